@@ -0,0 +1,45 @@
+#include "header.h"
+
+// хранилище строк для надписей панели: память берётся крупными блоками и не освобождается до конца работы,
+// поэтому указатели на строки остаются действительными, а одинаковые строки хранятся один раз;
+// для часто меняющегося текста выделяется изменяемая область фиксированного размера
+class StringArena {
+	private:
+		vector<unique_ptr<char[]>> blocks;
+		size_t block_size;
+		size_t used = 0;
+		unordered_map<string_view, const char*> interned;
+
+		char* allocate(size_t size) {
+			if (blocks.empty() || used + size > block_size) {
+				blocks.push_back(make_unique<char[]>(max(block_size, size)));
+				used = 0;
+			}
+			char* ptr = blocks.back().get() + used;
+			used += size;
+			return ptr;
+		}
+
+	public:
+		StringArena(size_t block_size = 4096) {
+			this->block_size = block_size;
+		}
+
+		const char* intern(const char* text) {
+			auto it = interned.find(string_view(text));
+			if (it != interned.end()) return it->second;
+			size_t len = strlen(text);
+			char* copy = this->allocate(len + 1);
+			memcpy(copy, text, len + 1);
+			interned[string_view(copy, len)] = copy;
+			return copy;
+		}
+
+		char* reserve(size_t size) {
+			char* ptr = this->allocate(size);
+			ptr[0] = '\0';
+			return ptr;
+		}
+};
+
+StringArena panel_strings = StringArena();
@@ -67,6 +67,10 @@ class CheckBox {
 			else btn1.render();
 		}
 
+		void reset() {
+			state = 0;
+		}
+
 		bool toggle() {
 			if ((state ? btn2 : btn1).isInside(GetMousePosition())) {
 				state ^= 1;
@@ -0,0 +1,90 @@
+#include "header.h"
+
+struct Event {
+	const char* type;
+	const char* first;
+	const char* second;
+	ld time;
+	ld value; // расстояние между телами (для перигелия - до Солнца)
+};
+
+// корень f на отрезке [a, b], на концах которого f разных знаков: метод ложного положения
+// с модификацией Иллинойс (значение на "застрявшем" конце делится пополам)
+ld refine_root(const function<ld(ld)> &f, ld a, ld b, ld fa, ld fb, ld tolerance) {
+	ld root = a;
+	int side = 0;
+	for (int i = 0; i < 50; i++) {
+		root = (a * fb - b * fa) / (fb - fa);
+		if (b - a < tolerance) break;
+		ld froot = f(root);
+		if (froot == 0) break;
+		if ((froot < 0) == (fa < 0)) {
+			a = root;
+			fa = froot;
+			if (side == -1) fb /= 2;
+			side = -1;
+		}
+		else {
+			b = root;
+			fb = froot;
+			if (side == 1) fa /= 2;
+			side = 1;
+		}
+	}
+	return root;
+}
+
+// минимум унимодальной на [a, b] функции методом золотого сечения
+ld refine_minimum(const function<ld(ld)> &f, ld a, ld b, ld tolerance) {
+	const ld ratio = (sqrt(5.0L) - 1) / 2;
+	ld c = b - ratio * (b - a), d = a + ratio * (b - a);
+	ld fc = f(c), fd = f(d);
+	while (b - a > tolerance) {
+		if (fc < fd) {
+			b = d;
+			d = c;
+			fd = fc;
+			c = b - ratio * (b - a);
+			fc = f(c);
+		}
+		else {
+			a = c;
+			c = d;
+			fc = fd;
+			d = a + ratio * (b - a);
+			fd = f(d);
+		}
+	}
+	return (a + b) / 2;
+}
+
+// корни f на [t0, t1], когда заранее неизвестно, где они лежат: знак проверяется на сетке с шагом step,
+// поэтому шаг должен быть меньше расстояния между соседними корнями
+vector<ld> find_roots(const function<ld(ld)> &f, ld t0, ld t1, ld step) {
+	vector<ld> roots;
+	ld a = t0;
+	ld fa = f(a);
+	while (a < t1) {
+		ld b = min(a + step, t1);
+		ld fb = f(b);
+		if ((fa < 0) != (fb < 0)) roots.push_back(refine_root(f, a, b, fa, fb, step * 1e-7));
+		a = b;
+		fa = fb;
+	}
+	return roots;
+}
+
+// локальные минимумы f на [t0, t1]: тройка соседних узлов сетки с меньшим значением в середине
+// даёт отрезок, на котором минимум уточняется
+vector<ld> find_minima(const function<ld(ld)> &f, ld t0, ld t1, ld step) {
+	vector<ld> minima;
+	ld prev = f(t0);
+	ld cur = f(t0 + step);
+	for (ld t = t0 + step; t + step <= t1; t += step) {
+		ld next = f(t + step);
+		if (cur < prev && cur <= next) minima.push_back(refine_minimum(f, t - step, t + step, step * 1e-5));
+		prev = cur;
+		cur = next;
+	}
+	return minima;
+}
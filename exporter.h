@@ -0,0 +1,106 @@
+#include "header.h"
+
+enum ExportFormat {EXPORT_PNG, EXPORT_RAW};
+
+// запись кадров: главный поток кладёт готовые изображения в ограниченную очередь,
+// рабочие потоки кодируют их в PNG или в сырые файлы RGBA, пока рисуется следующий кадр
+class FrameExporter {
+	private:
+		struct Frame {
+			Image image;
+			int number;
+		};
+
+		deque<Frame> frames;
+		mutex lock;
+		condition_variable has_frame; // очередь не пуста
+		condition_variable has_place; // в очереди есть место
+		vector<thread> workers;
+		ExportFormat format;
+		int threads;
+		int capacity;
+		int count = 0; // кадров отправлено на запись
+		bool running = 0;
+		char dir[64] = {0};
+
+		void encode(Frame &frame) {
+			char path[128];
+			if (format == EXPORT_PNG) {
+				snprintf(path, sizeof(path), "%s/frame_%06d.png", dir, frame.number);
+				ExportImage(frame.image, path);
+			}
+			else {
+				snprintf(path, sizeof(path), "%s/frame_%06d_%dx%d.rgba", dir, frame.number, frame.image.width, frame.image.height);
+				FILE *file = fopen(path, "wb");
+				if (file) {
+					fwrite(frame.image.data, 4, (size_t)frame.image.width * frame.image.height, file);
+					fclose(file);
+				}
+			}
+			UnloadImage(frame.image);
+		}
+
+		void work() {
+			while (1) {
+				unique_lock<mutex> guard(lock);
+				has_frame.wait(guard, [&]() {return !frames.empty() || !running; });
+				if (frames.empty()) return;
+				Frame frame = frames.front();
+				frames.pop_front();
+				guard.unlock();
+				has_place.notify_one();
+				this->encode(frame);
+			}
+		}
+
+	public:
+		FrameExporter(ExportFormat format, int threads, int capacity) {
+			this->format = format;
+			this->threads = max(1, threads);
+			this->capacity = capacity;
+		}
+
+		bool isRunning() {return running; }
+		int getCount() {return count; }
+		const char* getDir() {return dir; }
+
+		// каждая запись попадает в новую папку frames/run_NNN; 0 - папку создать не удалось, запись не начата
+		bool start() {
+			if (running) return 1;
+			error_code error;
+			for (int i = 1; ; i++) {
+				snprintf(dir, sizeof(dir), "frames/run_%03d", i);
+				if (! filesystem::exists(dir, error)) break;
+			}
+			if (! filesystem::create_directories(dir, error) || error) return 0;
+			count = 0;
+			running = 1;
+			for (int i = 0; i < threads; i++) workers.emplace_back(&FrameExporter::work, this);
+			return 1;
+		}
+
+		// если очередь заполнена, ждём освобождения места - так кодировщики притормаживают отрисовку
+		void push(Image image) {
+			unique_lock<mutex> guard(lock);
+			has_place.wait(guard, [&]() {return (int)frames.size() < capacity; });
+			frames.push_back({image, count++});
+			guard.unlock();
+			has_frame.notify_one();
+		}
+
+		// дописываем оставшиеся в очереди кадры и останавливаем потоки
+		void stop() {
+			if (! running) return;
+			{
+				lock_guard<mutex> guard(lock);
+				running = 0;
+			}
+			has_frame.notify_all();
+			for (auto &worker : workers) worker.join();
+			workers.clear();
+		}
+
+		~FrameExporter() {
+			this->stop();
+		}
+};
@@ -6,6 +6,19 @@
 #include <ctime>
 #include <random>
 #include <algorithm>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <string_view>
+#include <cstdarg>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <filesystem>
+#include <cstdio>
 
 #include "raylib.h"
 #include "raymath.h"
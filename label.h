@@ -2,9 +2,15 @@
 
 using namespace std;
 
+#include "arena.h"
+
+const int LABEL_SLOT = 128; // размер области для меняющегося текста надписи
+const int SUB_TEXT_SLOT = 1024;
+
 class Label {
 	protected:
-		char* text;
+		const char* text = "";
+		char* slot = nullptr; // область для format, выделяется в panel_strings при первом вызове
 		float x;
 		float y;
 		Font font;
@@ -33,8 +39,16 @@ class Label {
 		}
 
 		void setText(const char* info) {
-			text = new char[strlen(info) + 1];
-            strcpy(this->text, info);
+			text = panel_strings.intern(info);
+		}
+
+		void format(const char* fmt, ...) {
+			if (! slot) slot = panel_strings.reserve(LABEL_SLOT);
+			va_list args;
+			va_start(args, fmt);
+			vsnprintf(slot, LABEL_SLOT, fmt, args);
+			va_end(args);
+			text = slot;
 		}
 
 		virtual void render() {
@@ -44,7 +58,8 @@ class Label {
 
 class LabelWithText: public Label {
 	protected:
-		char* sub_text;
+		const char* sub_text = "";
+		char* sub_slot = nullptr;
 		int sub_size;
 		int lines;
 
@@ -53,9 +68,22 @@ class LabelWithText: public Label {
 
 	LabelWithText(const char* info, const char* sub_info, int lines, float x, float y, Font font, int font_size, int sub_size, Color font_color) :
 	Label(info, x, y, font, font_size, font_color) {
-		sub_text = new char[strlen(sub_info) + 1];
-		strcpy(this->sub_text, sub_info);
+		this->setSubText(sub_info, lines);
 		this->sub_size = sub_size;
+	}
+
+	void setSubText(const char* sub_info, int lines) {
+		sub_text = panel_strings.intern(sub_info);
+		this->lines = lines;
+	}
+
+	void formatSubText(int lines, const char* fmt, ...) {
+		if (! sub_slot) sub_slot = panel_strings.reserve(SUB_TEXT_SLOT);
+		va_list args;
+		va_start(args, fmt);
+		vsnprintf(sub_slot, SUB_TEXT_SLOT, fmt, args);
+		va_end(args);
+		sub_text = sub_slot;
 		this->lines = lines;
 	}
 
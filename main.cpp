@@ -2,6 +2,13 @@
 #include "textbox.h"
 #include "label.h"
 #include "button.h"
+#include "exporter.h"
+#include "workers.h"
+#include "events.h"
+#include "scheduler.h"
+#include "potential.h"
+#include "textures.h"
+#include "trail.h"
 
 using namespace std;
 
@@ -13,13 +20,58 @@ const Vector2 CENTER = {(WIDTH - BAR) / 2, HEIGHT / 2};
 
 const float ZOOM = 0.015; // начальное приближение камеры
 const float MIN_COEFF = 0.1;
-float COEFF = 500; // скорость движения
+const float BASE_COEFF = 500; // скорость движения, при которой комета делает за кадр один шаг H
+float COEFF = BASE_COEFF; // скорость движения
 float SCALE = 4; // масштаб для расстояний
+float VIEW_ZOOM = ZOOM; // приближение камеры, с которым рисуется текущий кадр (для выбора детализации текстур)
 const ld EPS = 1e-9;
 const ld G = 6.67e-11; // гравитационная постоянная
+const float H = 0.05; // базовый шаг интегрирования кометы
+const int MAX_LEVEL = 10; // наименьший шаг кометы - H / 2^MAX_LEVEL
+const ld ETA = 0.02; // точность выбора шага по ускорению и рывку
+const double COMET_BUDGET = 0.008; // сколько секунд за кадр можно тратить на комету, остальное переносится на следующие кадры
+const ld SOI_MARGIN = 1.5; // во сколько раз расширяем сферы действия планет при переходе к численному интегрированию
+const double NBODY_STEP = 1e-4; // шаг симплектического отображения в задаче N тел (в годах)
+const int NBODY_MAX_STEPS = 1000; // больше шагов за кадр не делаем, при сильном ускорении шаг кадра растёт
+
+const int EXPORT_WIDTH = 1920; // разрешение записываемых кадров
+const int EXPORT_HEIGHT = 1080;
+const ExportFormat EXPORT_FORMAT = EXPORT_PNG;
+const int EXPORT_QUEUE = 8; // сколько кадров может ждать кодирования
+
+const int SWEEP_MASSES = 8; // размеры сетки серии запусков
+const int SWEEP_VELOCITIES = 16;
+const int SWEEP_STARTS = 32;
+const float SWEEP_YEARS = 50; // сколько лет моделируется каждая комета
+const float SWEEP_MIN_VELOCITY = 10;
+const float SWEEP_MAX_VELOCITY = 160;
+const float EVENT_YEARS = 200; // на сколько лет вперёд ищутся события планет
+const float COMET_EVENT_YEARS = 2; // на сколько лет вперёд прослеживается траектория кометы
+const int EVENT_LIST = 10; // сколько ближайших событий показывается в подсказке
 
 mt19937 rnd(time(NULL));
 
+const int FPS = 60;
+const float MIN_MOTION = 0.5; // на сколько пикселей должно сдвинуться тело, чтобы кадр перерисовался
+
+const int POTENTIAL_CELL = 4; // размер ячейки поля потенциала в пикселях
+const float POTENTIAL_RADIUS = 96; // радиус пересчёта вокруг сдвинувшегося тела в пикселях
+
+const int LOD_LEVELS = 5; // уровни детализации текстур: исходный размер, 1/2, ..., 1/16
+const size_t TEXTURE_BUDGET = 8 << 20; // видеопамять под текстуры тел в байтах
+
+const int TRAIL_POINTS = 4096; // ёмкость следа кометы
+const float TRAIL_STEP = 5; // наименьшее расстояние между точками следа в единицах карты
+
+const int BELT_COUNT = 100000; // число астероидов в поясе
+const float BELT_INNER = 2.1; // границы пояса в радиусах орбиты Земли
+const float BELT_OUTER = 3.3;
+const int BELT_CHUNK = 4096; // столько астероидов пересчитывает одна задача пула
+const float BELT_SPRITE_SIZE = 4; // с какого размера в пикселях астероид рисуется спрайтом, а не точкой
+const int BELT_SATURATION = 16; // при таком числе астероидов в пикселе плотность рисуется непрозрачной
+const int BELT_PICTURE = 11; // текстура астероидов (Деймос)
+const float MIN_LABEL_SIZE = 6; // названия тел мельче стольких пикселей не рисуются
+
 const int SPACING = 1; // параметр для шрифта
 Font font;
 
@@ -32,24 +84,14 @@ Color font_color = Color({86, 19, 124, 255});
 Color error_color = Color({158, 26, 47, 255});
 Color textbox_color = Color({234, 216, 243, 255});
 Color help_rect = Color({221, 213, 213, 255});
+Color trail_color = Color({120, 200, 255, 180});
 
 vector<const char*> paths = {"sun.png", "mercury.png", "venus.png", "earth.png", "mars.png", "jupiter.png", 
 							 "saturn.png", "uranus.png", "neptune.png", "moon.png", "phobos.png", "deimos.png",
 							 "io.png", "europe.png", "ganymede.png", "callisto.png", "comet.png"};
-vector<Image> images(paths.size());
-vector<Texture2D> textures(paths.size());
+TextureCache textures = TextureCache(paths, LOD_LEVELS, TEXTURE_BUDGET);
 vector<int> show_object(paths.size(), 1);
 
-void load_images() {
-	for (int i = 0; i < paths.size(); i++) {
-		const char* path = TextFormat("assets/%s", paths[i]);
-		Image image = LoadImage(path);
-		images[i] = image;
-		Texture2D texture = LoadTextureFromImage(image);
-		textures[i] = texture;
-	}
-}
-
 void load_font() {
 	int codepoints[512] = { 0 };
 	for (int i = 0; i < 95; i++) codepoints[i] = 32 + i;   // символы ASCII
@@ -60,18 +102,84 @@ void load_font() {
 // E - e * sin(E) = M; ищем корни трансцендентного уравнения Кеплера методом Ньютона
 // f(E) = E - e * sin(E) - M, f'(E) = 1 - e * cos(E)
 
-ld kepler(ld M, ld e) {
-	ld E = M;
+template <typename T>
+T kepler(T M, T e) {
+	T E = M;
 	for (int i = 0; i < 100; i++) {
-		ld f = E - e * sin(E) - M;
-		ld f_deriv = 1 - e * cos(E);
-		ld d = f / f_deriv;
+		T f = E - e * sin(E) - M;
+		T f_deriv = 1 - e * cos(E);
+		T d = f / f_deriv;
 		E -= d;
 		if (abs(d) < EPS) break;
 	}
 	return E;
 }
 
+// функции Штумпфа C(z) и S(z) для универсальной переменной (z > 0 - эллипс, z < 0 - гипербола, z = 0 - парабола)
+template <typename T>
+T stumpff_c(T z) {
+	if (z > EPS) return (1 - cos(sqrt(z))) / z;
+	if (z < -EPS) return (cosh(sqrt(-z)) - 1) / (-z);
+	return T(1) / 2 - z / 24 + z * z / 720;
+}
+
+template <typename T>
+T stumpff_s(T z) {
+	if (z > EPS) return (sqrt(z) - sin(sqrt(z))) / pow(sqrt(z), 3);
+	if (z < -EPS) return (sinh(sqrt(-z)) - sqrt(-z)) / pow(sqrt(-z), 3);
+	return T(1) / 6 - z / 120 + z * z / 5040;
+}
+
+// задача двух тел в универсальной переменной chi: сдвигаем положение (x, y) и скорость (vx, vy) относительно
+// притягивающего центра на время dt >= 0; уравнение Кеплера
+// F(chi) = r0 * vr0 / sqrt(mu) * chi^2 * C + (1 - alpha * r0) * chi^3 * S + r0 * chi - sqrt(mu) * dt = 0
+// решаем методом Ньютона, затем переходим к новым координатам через функции Лагранжа f, g.
+// F возрастает (F' = r > 0), поэтому корень держим в отрезке [lo, hi]: шаг Ньютона, вышедший из отрезка
+// (или переполнение cosh на гиперболе), заменяем делением отрезка пополам
+template <typename T>
+void kepler_universal(T mu, T dt, T &x, T &y, T &vx, T &vy) {
+	if (dt <= 0) return;
+	T r0 = sqrt(x * x + y * y);
+	T vr0 = (x * vx + y * vy) / r0;
+	T alpha = 2 / r0 - (vx * vx + vy * vy) / mu; // 1 / a
+	T sqrt_mu = sqrt(mu);
+	T chi = sqrt_mu * dt / r0;
+	if (alpha > EPS) chi = sqrt_mu * alpha * dt;
+	else if (alpha < -EPS) {
+		// гипербола: приближение по асимптотическому движению (Vallado)
+		T a = 1 / alpha;
+		T guess = sqrt(-a) * log(-2 * mu * alpha * dt / (r0 * vr0 + sqrt(-mu * a) * (1 - r0 * alpha)));
+		if (isfinite(guess) && guess > 0) chi = guess;
+	}
+	T lo = 0, hi = INFINITY;
+	for (int i = 0; i < 200; i++) {
+		T z = alpha * chi * chi;
+		T C = stumpff_c(z), S = stumpff_s(z);
+		T F = r0 * vr0 / sqrt_mu * chi * chi * C + (1 - alpha * r0) * chi * chi * chi * S + r0 * chi - sqrt_mu * dt;
+		T F_deriv = r0 * vr0 / sqrt_mu * chi * (1 - z * S) + (1 - alpha * r0) * chi * chi * C + r0;
+		if (F == 0) break;
+		if (! isfinite(F) || F > 0) hi = chi;
+		else lo = chi;
+		T next = chi - F / F_deriv;
+		if (! isfinite(next) || next <= lo || next >= hi) next = isinf(hi) ? 2 * chi : (lo + hi) / 2;
+		T d = next - chi;
+		chi = next;
+		if (abs(d) < EPS * max(T(1), abs(chi))) break;
+	}
+	T z = alpha * chi * chi;
+	T C = stumpff_c(z), S = stumpff_s(z);
+	T f = 1 - chi * chi / r0 * C;
+	T g = dt - chi * chi * chi * S / sqrt_mu;
+	T nx = f * x + g * vx;
+	T ny = f * y + g * vy;
+	T r = sqrt(nx * nx + ny * ny);
+	T f_dot = sqrt_mu / (r * r0) * (z * S - 1) * chi;
+	T g_dot = 1 - chi * chi / r * C;
+	T nvx = f_dot * x + g_dot * vx;
+	T nvy = f_dot * y + g_dot * vy;
+	x = nx, y = ny, vx = nvx, vy = nvy;
+}
+
 class CosmicObject {
 	protected:
 		ld mass;
@@ -94,12 +202,17 @@ class CosmicObject {
 		}
 
 		ld getMass() {return mass; }
+
+		// радиус изображения объекта на карте
+		float getRadius() {return diam / (picture_id ? 1e2 : 1e4) / 2; }
 		
 		const char* getName() {return name; }
 		virtual const char* getType() {return type; }
 
 		const char* getInfo() {
-			return TextFormat("%s - %s\nс массой %Le кг.", name, this->getType(), mass); 
+			char info[256];
+			snprintf(info, sizeof(info), "%s - %s\nс массой %Le кг.", name, this->getType(), mass);
+			return panel_strings.intern(info);
 		}
 
 		Vector2 getCoords() {
@@ -121,14 +234,12 @@ class CosmicObject {
 
 		virtual void render(float angle=0) {
 			if (! show_object[picture_id]) return;
-			Image image = images[picture_id];
-			float scale = (picture_id ? 1e2 : 1e4);
-			image_width = image_height = diam / scale;
-			Texture2D texture = textures[picture_id];
+			image_width = image_height = 2 * this->getRadius();
+			Texture2D texture = textures.get(picture_id, image_width * VIEW_ZOOM);
 			Rectangle src = {0, 0, (float)texture.width, (float)texture.height};
-			Rectangle dest = {x, y, diam / scale, diam / scale};
+			Rectangle dest = {x, y, image_width, image_height};
 			DrawTexturePro(texture, src, dest, {dest.width / 2, dest.height / 2}, angle, WHITE);
-			if (show_text) {
+			if (show_text && 40 * VIEW_ZOOM >= MIN_LABEL_SIZE) {
 				auto [image_x, image_y] = getCoords();
 				DrawTextEx(font, name, {image_x, image_y}, 40, SPACING, WHITE);
 			}
@@ -160,16 +271,34 @@ class RotatingObject: public CosmicObject {
 
 		virtual ld getA() {return a; }
 		virtual ld getB() {return a * sqrt(1 - e * e); }
+
+		ld getAxis() {return a; } // большая полуось без поправки на размеры изображений
 		
 		virtual float center_x() {return 0; }
 		virtual float center_y() {return 0; }
 
-		void updateCoords(ld t) {
-			ld M = 2 * PI * (t / (COEFF * T));
-			while (M > 2 * PI) M -= 2 * PI;	
-			ld E = kepler(M, e);
-			x = center_x() + getA() * (cos(E) - e);
-			y = center_y() + getB() * sin(E);
+		ld getPeriod() {return T; }
+
+		ld getEccentricity() {return e; }
+
+		// положение на орбите в момент t (сам объект не сдвигается); для координат на карте хватает double
+		Vector2 getPosition(ld t, float coeff = COEFF) {
+			double M = fmod(2 * PI * (double)(t / (coeff * T)), 2 * PI);
+			double E = kepler(M, (double)e);
+			return {(float)(center_x() + getA() * (cos(E) - e)), (float)(center_y() + getB() * sin(E))};
+		}
+
+		// скорость на орбите в текущей точке в единицах карты за год
+		Vector2 getVelocity() {
+			double E = atan2((y - center_y()) / getB(), (x - center_x()) / getA() + e);
+			double E_dot = 2 * PI / T / (1 - e * cos(E));
+			return {(float)(-getA() * sin(E) * E_dot), (float)(getB() * cos(E) * E_dot)};
+		}
+
+		void updateCoords(ld t, float coeff = COEFF) {
+			Vector2 pos = this->getPosition(t, coeff);
+			x = pos.x;
+			y = pos.y;
 		}
 
 		void drawOrbit() {
@@ -191,12 +320,26 @@ class RotatingObject: public CosmicObject {
 };
 
 class Planet: public RotatingObject {
+	protected:
+		ld soi = 0; // радиус сферы действия
+
 	public:
 		Planet(): RotatingObject() {
 			this->type = "планета";
 			this->orbit_color = BLUE;
 		}
 
+		// наибольшая (в перигелии) скорость на орбите в единицах карты за год
+		ld getSpeed() {
+			return 2 * PI * a / T * sqrt((1 + e) / (1 - e));
+		}
+
+		// сфера действия планеты: r = a * (m / M)^(2/5)
+		ld getSOI(CosmicObject *sun) {
+			if (! soi) soi = a * pow(mass / sun->getMass(), 0.4L);
+			return soi;
+		}
+
 		float center_x() {return CENTER.x; }
 		float center_y() {return CENTER.y; }
 };
@@ -329,9 +472,13 @@ class Satellite: public RotatingObject {
 		float center_x() {return planet->x; }
 		float center_y() { return planet->y; }
 
+		Planet* getPlanet() {return planet; }
+
 		const char* getType() {
-			return TextFormat("%s планеты %s", type, planet->getName());
-		} 
+			char info[128];
+			snprintf(info, sizeof(info), "%s планеты %s", type, planet->getName());
+			return panel_strings.intern(info);
+		}
 };
 
 class Moon: public Satellite {
@@ -430,6 +577,7 @@ class Comet: public CosmicObject {
 		Vector2 velocity;
 		float density; // плотность
 		float scale; // масштаб
+		Trail trail = Trail(TRAIL_POINTS, TRAIL_STEP); // пройденный путь
 	
 	public:
 		Comet() : CosmicObject() {
@@ -450,6 +598,7 @@ class Comet: public CosmicObject {
 		void setCoords() {
 			this->x = rnd() % (WIDTH - BAR);
 			this->y = rnd() % (HEIGHT);
+			trail.clear();
 		}
 
 		void setMass(ld mass) {
@@ -482,34 +631,843 @@ class Comet: public CosmicObject {
 			return a;
 		}
 	
+		// производная ускорения (рывок): j = -GM * (v / r^3 - 3 * (r, v) * r / r^5), где r и v - относительно тела;
+		// Солнце неподвижно, скорость планеты переводим из лет во время кометы
+		Vector2 getJerk(Vector2 pos, Vector2 velocity, Sun *sun, vector<Planet*> &planets) {
+			ld jx = 0, jy = 0;
+			auto add = [&](CosmicObject *body, Vector2 body_velocity) {
+				ld dx = (pos.x - body->x) * 1e7;
+				ld dy = (pos.y - body->y) * 1e7;
+				ld dvx = (velocity.x - body_velocity.x) * 1e7;
+				ld dvy = (velocity.y - body_velocity.y) * 1e7;
+				ld r2 = dx * dx + dy * dy;
+				ld r3 = sqrt(r2) * r2;
+				ld rv = 3 * (dx * dvx + dy * dvy) / r2;
+				jx -= G * body->getMass() * (dvx - rv * dx) / r3;
+				jy -= G * body->getMass() * (dvy - rv * dy) / r3;
+			};
+			add(sun, {0, 0});
+			for (int i = 0; i < planets.size(); i++) add(planets[i], planets[i]->getVelocity() / BASE_COEFF);
+			return {(float)jx, (float)jy};
+		}
+
 		pair<Vector2, Vector2> deriv(Vector2 pos, Vector2 velocity, Sun *sun, vector<Planet*> &planets) {
 			return {velocity, getA(pos, sun, planets)};
 		}
 
-		// нахождение новых координат методом Рунге-Кутта: y(n + 1) = y(n) + h / 6 * (k1 + 2 * k2 + 2 * k3 + k4)
-		void updateCoords(Sun *sun, vector<Planet*> &planets) {
+		// уровень шага: h / 2^level не больше ETA * |a| / |j| (критерий по ускорению и рывку)
+		int chooseLevel(Sun *sun, vector<Planet*> &planets) {
 			Vector2 a = this->getA({x, y}, sun, planets);
-			float h = 0.05;
+			Vector2 j = this->getJerk({x, y}, velocity, sun, planets);
+			ld a_len = sqrt((ld)a.x * a.x + (ld)a.y * a.y);
+			ld j_len = sqrt((ld)j.x * j.x + (ld)j.y * j.y);
+			if (j_len < EPS) return 0;
+			ld dt = ETA * a_len / j_len;
+			int level = 0;
+			while (level < MAX_LEVEL && H / (1 << level) > dt) level++;
+			return level;
+		}
+
+		// один шаг методом Рунге-Кутта: y(n + 1) = y(n) + h / 6 * (k1 + 2 * k2 + 2 * k3 + k4)
+		void step(float h, Sun *sun, vector<Planet*> &planets) {
 			auto k1 = deriv({x, y}, velocity, sun, planets);
 			auto k2 = deriv({x + k1.first.x * h / 2, y + k1.first.y * h / 2}, velocity + k1.second * h / 2, sun, planets);
 			auto k3 = deriv({x + k2.first.x * h / 2, y + k2.first.y * h / 2}, velocity + k2.second * h / 2, sun, planets);
 			auto k4 = deriv({x + k3.first.x * h, y + k3.first.y * h}, velocity + k3.second * h, sun, planets);
-			float ox = x, oy = y;
 			x += (h / 6) * (k1.first.x + k2.first.x * 2 + k3.first.x * 2 + k4.first.x);
 			y += (h / 6) * (k1.first.y + k2.first.y * 2 + k3.first.y * 2 + k4.first.y);
 			velocity += (k1.second + k2.second * 2 + k3.second * 2 + k4.second) * h / 6;
 		}
 
+		// вне сфер действия всех планет комета движется по коническому сечению вокруг Солнца;
+		// запас |v| * dt не даёт ей за время dt влететь в сферу незамеченной
+		// время кометы связано с годами планет как t_years = t_comet / BASE_COEFF, за dt сближаются и комета, и планета
+		bool isFar(Sun *sun, vector<Planet*> &planets, ld dt) {
+			float reach = Vector2Length(velocity) * dt;
+			for (auto planet : planets) {
+				ld planet_reach = planet->getSpeed() / BASE_COEFF * dt;
+				if (hypot(x - planet->x, y - planet->y) < SOI_MARGIN * planet->getSOI(sun) + reach + planet_reach) return 0;
+			}
+			return 1;
+		}
+
+		// сдвиг по орбите вокруг Солнца без численного интегрирования (ускорение GM / r^2 в единицах карты - как в getA)
+		// если решение всё же не конечно (переполнение на очень длинной гиперболе), делим отрезок пополам
+		void drift(ld dt, Sun *sun) {
+			double mu = G * sun->getMass() * 1e-14;
+			double rx = x - sun->x, ry = y - sun->y;
+			double vx = velocity.x, vy = velocity.y;
+			kepler_universal(mu, (double)dt, rx, ry, vx, vy);
+			if (! (isfinite(rx) && isfinite(ry) && isfinite(vx) && isfinite(vy)) && dt > H) {
+				this->drift(dt / 2, sun);
+				this->drift(dt / 2, sun);
+				return;
+			}
+			x = sun->x + rx;
+			y = sun->y + ry;
+			velocity = {(float)vx, (float)vy};
+		}
+
+		// блочные шаги: шаг h делится на 2^level частей, мелкие шаги берутся только при сближениях;
+		// время внутри h считаем в тиках 2^-MAX_LEVEL, укрупнять шаг можно только на границе его блока
+		void blockStep(float h, Sun *sun, vector<Planet*> &planets) {
+			const int ticks = 1 << MAX_LEVEL;
+			int tick = 0;
+			while (tick < ticks) {
+				int level = this->chooseLevel(sun, planets);
+				while (level < MAX_LEVEL && tick % (ticks >> level) != 0) level++;
+				this->step(h / (1 << level), sun, planets);
+				tick += ticks >> level;
+			}
+		}
+
+		// до Солнца за dt не долететь: быстрее, чем у его поверхности, комета не движется
+		bool sunFar(Sun *sun, ld dt) {
+			ld mu = G * sun->getMass() * 1e-14;
+			ld impact = sun->getRadius() + this->getRadius();
+			return hypot(x - sun->x, y - sun->y) - impact > sqrt(2 * (this->getEnergy(sun) + mu / impact)) * dt;
+		}
+
+		// аналитический сдвиг с записью следа: точка через каждые TRAIL_STEP пути, но не больше TRAIL_POINTS на отрезок
+		void traceDrift(ld dt, Sun *sun) {
+			ld least = dt / TRAIL_POINTS;
+			while (dt > EPS) {
+				ld piece = min(dt, max((ld)TRAIL_STEP / Vector2Length(velocity), least));
+				this->drift(piece, sun);
+				trail.push({x, y});
+				dt -= piece;
+			}
+		}
+
+		// один кусок движения длиной не больше dt, возвращает его длину; place(offset) ставит планеты в момент
+		// через offset (во времени кометы) от начала куска. Вдали от планет и Солнца кусок проходится аналитически,
+		// отрезок делится пополам, пока сближение на нём не исключено; рядом - блочным шагом не больше H
+		// с планетами в середине шага. След (trace) пишется только для показываемой кометы
+		ld advance(Sun *sun, vector<Planet*> &planets, ld dt, const function<void(ld)> &place, bool trace = 0) {
+			place(0);
+			auto clear = [&](ld dt) {return this->isFar(sun, planets, dt) && this->sunFar(sun, dt); };
+			while (dt > H && ! clear(dt)) dt /= 2;
+			if (clear(dt)) {
+				if (trace) this->traceDrift(dt, sun);
+				else this->drift(dt, sun);
+				return dt;
+			}
+			dt = min(dt, (ld)H);
+			place(dt / 2);
+			this->blockStep(dt, sun, planets);
+			if (trace) trail.push({x, y});
+			return dt;
+		}
+
+		// сдвиг на время dt целиком, планеты ставит place, как в advance
+		void updateCoords(Sun *sun, vector<Planet*> &planets, ld dt, const function<void(ld)> &place) {
+			ld done = 0;
+			while (dt - done > EPS) {
+				done += this->advance(sun, planets, dt - done, [&](ld offset) {place(done + offset); });
+			}
+		}
+
+		Vector2 getVelocity() {return velocity; }
+
+		// удельная энергия относительно Солнца в единицах карты: E = v^2 / 2 - GM / r, где GM пересчитано
+		// так же, как в getA (a = GM * 1e-14 / r^2); E < 0 - комета связана с Солнцем
+		ld getEnergy(Sun *sun) {
+			ld dx = x - sun->x;
+			ld dy = y - sun->y;
+			ld r = sqrt(dx * dx + dy * dy);
+			ld v2 = (ld)velocity.x * velocity.x + (ld)velocity.y * velocity.y;
+			return v2 / 2 - G * sun->getMass() * 1e-14 / r;
+		}
+
 		void render() {
+			if (show_object[picture_id]) trail.render(trail_color);
 			float angle = atan2(velocity.y, velocity.x);
 			CosmicObject::render(angle / PI * 180);
 		}
 };
 
+// OUTCOME_BOUND - комета связана с Солнцем с самого начала и не уходила с орбиты, момента исхода у неё нет
+enum Outcome {OUTCOME_ESCAPE, OUTCOME_CAPTURE, OUTCOME_IMPACT, OUTCOME_BOUND};
+
+struct SweepResult {
+	ld mass;
+	float velocity;
+	Vector2 start;
+	Outcome outcome;
+	float time; // через сколько лет ушла, захвачена или столкнулась; -1 - момента нет
+};
+
+// серия запусков: сетка масс, скоростей и начальных точек, каждая комета моделируется независимо в пуле потоков
+class CometSweep {
+	private:
+		WorkerPool pool;
+		thread runner;
+		vector<SweepResult> results;
+		Sun sun;
+		vector<Planet> planets; // копии планет на момент запуска серии
+		ld t0;
+		float coeff;
+		atomic<int> done = 0;
+		atomic<bool> running = 0;
+		atomic<bool> cancelled = 0;
+
+		SweepResult simulate(int index) {
+			int mi = index / (SWEEP_VELOCITIES * SWEEP_STARTS);
+			int vi = index / SWEEP_STARTS % SWEEP_VELOCITIES;
+			int si = index % SWEEP_STARTS;
+			ld mass = pow(10.0L, mi);
+			float velocity = SWEEP_MIN_VELOCITY + (SWEEP_MAX_VELOCITY - SWEEP_MIN_VELOCITY) * vi / (SWEEP_VELOCITIES - 1);
+			// начальные точки - узлы сетки 8 x 4 в той же области, где model_comet выбирает случайную точку
+			Vector2 start = {(si % 8 + 0.5f) * (WIDTH - BAR) / 8, (si / 8 + 0.5f) * HEIGHT / 4};
+			SweepResult result = {mass, velocity, start, OUTCOME_CAPTURE, -1};
+
+			vector<Planet> local = planets;
+			vector<Planet*> ptrs;
+			for (auto &planet : local) ptrs.push_back(&planet);
+			Comet comet = Comet(mass, velocity);
+			comet.x = start.x;
+			comet.y = start.y;
+			ld impact = sun.getRadius() + comet.getRadius();
+			auto planets_at = [&](ld time) { // время кометы -> часы планет
+				for (auto planet : ptrs) planet->updateCoords(t0 + time * coeff / BASE_COEFF, coeff);
+			};
+			// дальше этого радиуса не достать ни одну планету: афелий плюс радиус столкновения и сфера действия
+			ld outer = 0;
+			for (auto planet : ptrs) {
+				outer = max(outer, planet->getAxis() * (1 + planet->getEccentricity()) + planet->getRadius() + comet.getRadius() +
+								   SOI_MARGIN * planet->getSOI(&sun));
+			}
+			bool bound = comet.getEnergy(&sun) < 0;
+			bool left = 0; // была ли комета хоть раз не связана с Солнцем
+			ld horizon = SWEEP_YEARS * BASE_COEFF, time = 0;
+			while (time < horizon && ! cancelled) {
+				time += comet.advance(&sun, ptrs, horizon - time, [&](ld offset) {planets_at(time + offset); });
+				for (auto planet : ptrs) {
+					if (hypot(comet.x - planet->x, comet.y - planet->y) < planet->getRadius() + comet.getRadius()) {
+						result.outcome = OUTCOME_IMPACT;
+						result.time = time / BASE_COEFF;
+						return result;
+					}
+				}
+				ld dx = comet.x - sun.x, dy = comet.y - sun.y;
+				if (hypot(dx, dy) < impact) {
+					result.outcome = OUTCOME_IMPACT;
+					result.time = time / BASE_COEFF;
+					return result;
+				}
+				bool now_bound = comet.getEnergy(&sun) < 0;
+				Vector2 v = comet.getVelocity();
+				// не связана, удаляется от Солнца и уже за орбитами всех планет - назад не вернётся и ни с чем не столкнётся
+				if (! now_bound && dx * v.x + dy * v.y > 0 && hypot(dx, dy) > outer) {
+					result.outcome = OUTCOME_ESCAPE;
+					result.time = time / BASE_COEFF;
+					return result;
+				}
+				if (! now_bound) left = 1;
+				if (now_bound && ! bound) result.time = time / BASE_COEFF; // захват - последний переход на связанную орбиту
+				bound = now_bound;
+			}
+			if (! left) result = {mass, velocity, start, OUTCOME_BOUND, -1};
+			else if (! bound) result = {mass, velocity, start, OUTCOME_ESCAPE, -1}; // не связана, но к концу счёта ещё не ушла
+			return result;
+		}
+
+		void save(const char* path) {
+			FILE *file = fopen(path, "w");
+			if (! file) return;
+			const char* names[] = {"escape", "capture", "impact", "bound"};
+			fprintf(file, "mass,velocity,x,y,outcome,years\n");
+			for (auto &result : results) {
+				fprintf(file, "%Le,%g,%g,%g,%s,", result.mass, result.velocity, result.start.x, result.start.y, names[result.outcome]);
+				if (result.time >= 0) fprintf(file, "%g", result.time);
+				fprintf(file, "\n");
+			}
+			fclose(file);
+		}
+
+	public:
+		CometSweep() {}
+
+		int size() {return SWEEP_MASSES * SWEEP_VELOCITIES * SWEEP_STARTS; }
+		bool isRunning() {return running; }
+		bool isReady() {return ! running && ! results.empty(); }
+		int getProgress() {return 100 * done / this->size(); }
+
+		void start(Sun *sun, vector<Planet*> &planets, ld t) {
+			this->cancel();
+			this->sun = *sun;
+			this->planets.clear();
+			for (auto planet : planets) this->planets.push_back(*planet);
+			t0 = t;
+			coeff = COEFF;
+			results.assign(this->size(), SweepResult());
+			done = 0;
+			cancelled = 0;
+			running = 1;
+			runner = thread([this]() {
+				pool.run(this->size(), [this](int index) {
+					results[index] = this->simulate(index);
+					done++;
+				});
+				if (! cancelled) this->save("sweep.csv");
+				else results.clear();
+				running = 0;
+			});
+		}
+
+		void cancel() {
+			cancelled = 1;
+			if (runner.joinable()) runner.join();
+		}
+
+		// тепловая карта: строки - массы, столбцы - скорости; красный - доля ухода, зелёный - захвата, синий - столкновений,
+		// серый - комет, связанных с Солнцем с самого начала
+		void render(Font font, Rectangle area) {
+			float cell_w = area.width / SWEEP_VELOCITIES;
+			float cell_h = area.height / SWEEP_MASSES;
+			Vector2 mouse = GetMousePosition();
+			const char* hint = nullptr;
+			for (int mi = 0; mi < SWEEP_MASSES; mi++) {
+				for (int vi = 0; vi < SWEEP_VELOCITIES; vi++) {
+					int count[4] = {0}, timed[4] = {0};
+					float time[4] = {0};
+					for (int si = 0; si < SWEEP_STARTS; si++) {
+						auto &result = results[(mi * SWEEP_VELOCITIES + vi) * SWEEP_STARTS + si];
+						count[result.outcome]++;
+						if (result.time < 0) continue;
+						time[result.outcome] += result.time;
+						timed[result.outcome]++;
+					}
+					Rectangle cell = {area.x + vi * cell_w, area.y + mi * cell_h, cell_w, cell_h};
+					int gray = 120 * count[OUTCOME_BOUND] / SWEEP_STARTS;
+					Color color = {(unsigned char)(255 * count[OUTCOME_ESCAPE] / SWEEP_STARTS + gray),
+								   (unsigned char)(255 * count[OUTCOME_CAPTURE] / SWEEP_STARTS + gray),
+								   (unsigned char)(255 * count[OUTCOME_IMPACT] / SWEEP_STARTS + gray), 230};
+					DrawRectangleRec(cell, color);
+					if (CheckCollisionPointRec(mouse, cell)) {
+						for (int k = 0; k < 4; k++) {
+							if (timed[k]) time[k] /= timed[k];
+						}
+						hint = TextFormat("m = %.0e, v = %.0f\nуход: %d (%.2f г.)\nзахват: %d (%.2f г.)\nстолкновение: %d (%.2f г.)\nсвязаны с начала: %d",
+										  (double)pow(10.0L, mi), SWEEP_MIN_VELOCITY + (SWEEP_MAX_VELOCITY - SWEEP_MIN_VELOCITY) * vi / (SWEEP_VELOCITIES - 1),
+										  count[OUTCOME_ESCAPE], time[OUTCOME_ESCAPE], count[OUTCOME_CAPTURE], time[OUTCOME_CAPTURE],
+										  count[OUTCOME_IMPACT], time[OUTCOME_IMPACT], count[OUTCOME_BOUND]);
+					}
+				}
+			}
+			DrawRectangleLines(area.x, area.y, area.width, area.height, WHITE);
+			DrawTextEx(font, TextFormat("скорость: %.0f - %.0f", SWEEP_MIN_VELOCITY, SWEEP_MAX_VELOCITY), {area.x, area.y - 25}, 25, SPACING, WHITE);
+			DrawTextEx(font, TextFormat("масса: 1 - %.0e (сверху вниз)", pow(10.0, SWEEP_MASSES - 1)), {area.x, area.y + area.height + 2}, 25, SPACING, WHITE);
+			if (hint) {
+				DrawRectangle(mouse.x, mouse.y, 260, 130, RAYWHITE);
+				DrawTextEx(font, hint, {mouse.x + 2, mouse.y}, 25, SPACING, BLACK);
+			}
+		}
+
+		~CometSweep() {
+			this->cancel();
+		}
+};
+
+// поиск событий: соединения и противостояния (для пар с Землёй - как их видно с Земли, для остальных - по сторонам от Солнца),
+// наибольшие сближения и прохождения перигелия; вместо перебора по кадрам корни и минимумы гладких функций
+// времени ищутся на сетке с шагом в долю синодического периода и затем уточняются
+class EventSearch {
+	private:
+		vector<Event> events;
+		map<Planet*, ld> center; // уравнение центра для каждой планеты
+		char list[1024] = {0};
+
+		// наибольшее отличие истинной аномалии от средней (уравнение центра) с небольшим запасом
+		static ld center_equation(ld e) {
+			ld best = 0;
+			for (int i = 0; i < 360; i++) {
+				ld M = 2 * PI * i / 360;
+				ld E = kepler(M, e);
+				ld nu = atan2(sqrt(1 - e * e) * sin(E), cos(E) - e);
+				best = max(best, abs(remainder(nu - M, 2 * PI)));
+			}
+			return best * 1.1 + 1e-3;
+		}
+
+		// все тела стартуют из перигелия при t = 0, поэтому разность средних аномалий пары равна w * t;
+		// истинные аномалии отличаются от средних не больше чем на c = c1 + c2, так что каждое соединение
+		// и противостояние лежит в отрезке, где w * t отличается от k * pi не больше чем на c
+		void searchPair(Sun *sun, Planet *p, Planet *q, ld t0, ld t1, float coeff, vector<Event> &found) {
+			ld w = 2 * PI / coeff * (1 / p->getPeriod() - 1 / q->getPeriod());
+			if (w < 0) swap(p, q), w = -w;
+			ld c = center.at(p) + center.at(q);
+			ld synodic = 2 * PI / w;
+			Vector2 origin = {sun->x, sun->y};
+			// sin угла между направлениями от Солнца: ноль при соединении (cos > 0) и противостоянии (cos < 0)
+			auto angle = [&](ld t) {
+				Vector2 a = p->getPosition(t, coeff) - origin;
+				Vector2 b = q->getPosition(t, coeff) - origin;
+				return (ld)(a.x * b.y - a.y * b.x) / (Vector2Length(a) * Vector2Length(b));
+			};
+			auto sep = [&](ld t) {
+				return (ld)Vector2Distance(p->getPosition(t, coeff), q->getPosition(t, coeff));
+			};
+			bool earth = ! strcmp(p->getName(), "Земля") || ! strcmp(q->getName(), "Земля");
+			// пары с Землёй называем так, как их видно с Земли: внешняя планета на одной стороне с Землёй -
+			// противостояние, по другую сторону Солнца - соединение; внутренняя - нижнее и верхнее соединение
+			const char *same_name = "соединение", *opposite_name = "противостояние";
+			if (earth) {
+				Planet *other = strcmp(p->getName(), "Земля") ? p : q;
+				Planet *home = other == p ? q : p;
+				bool inner = other->getAxis() < home->getAxis();
+				same_name = inner ? "нижнее соединение" : "противостояние";
+				opposite_name = inner ? "верхнее соединение" : "соединение";
+			}
+			for (long long k = ceil((w * t0 - c) / PI); k * PI - c <= w * t1; k++) {
+				ld a = max(t0, (k * PI - c) / w);
+				ld b = min(t1, (k * PI + c) / w);
+				ld fa = angle(a), fb = angle(b);
+				if ((fa < 0) == (fb < 0)) continue;
+				ld t = refine_root(angle, a, b, fa, fb, synodic * 1e-7);
+				Vector2 u = p->getPosition(t, coeff) - origin;
+				Vector2 v = q->getPosition(t, coeff) - origin;
+				bool same_side = u.x * v.x + u.y * v.y > 0;
+				found.push_back({same_side ? same_name : opposite_name, p->getName(), q->getName(), t, Vector2Distance(u, v)});
+				// для Земли ищем и наибольшее сближение - оно рядом с противостоянием или нижним соединением
+				if (earth && same_side) {
+					ld m = refine_minimum(sep, max(t0, t - synodic / 8), min(t1, t + synodic / 8), synodic * 1e-5);
+					found.push_back({"сближение", p->getName(), q->getName(), m, sep(m)});
+				}
+			}
+		}
+
+		// перигелий планеты - моменты, когда средняя аномалия кратна 2pi
+		void searchPerihelion(Sun *sun, Planet *p, ld t0, ld t1, float coeff, vector<Event> &found) {
+			ld period = p->getPeriod() * coeff;
+			for (long long k = ceil(t0 / period); k * period <= t1; k++) {
+				Vector2 pos = p->getPosition(k * period, coeff);
+				found.push_back({"перигелий", p->getName(), "", k * period, Vector2Distance(pos, {sun->x, sun->y})});
+			}
+		}
+
+		// пары планет независимы, поэтому считаются в пуле потоков, каждая в свой список
+		void searchPlanets(WorkerPool *pool, Sun *sun, vector<Planet*> &planets, ld t0, ld t1, float coeff) {
+			vector<pair<int, int>> pairs;
+			for (int i = 0; i < planets.size(); i++) {
+				for (int j = i + 1; j < planets.size(); j++) pairs.push_back({i, j});
+			}
+			for (auto planet : planets) {
+				if (! center.count(planet)) center[planet] = center_equation(planet->getEccentricity());
+			}
+			vector<vector<Event>> found(pairs.size() + planets.size());
+			pool->run(found.size(), [&](int index) {
+				if (index < pairs.size()) {
+					auto [i, j] = pairs[index];
+					this->searchPair(sun, planets[i], planets[j], t0, t1, coeff, found[index]);
+				}
+				else this->searchPerihelion(sun, planets[index - pairs.size()], t0, t1, coeff, found[index]);
+			});
+			for (auto &list : found) events.insert(events.end(), list.begin(), list.end());
+		}
+
+		// траектория кометы интегрируется с шагом H, между узлами положение восстанавливается кубическим
+		// многочленом Эрмита по координатам и скоростям
+		void searchComet(Comet comet, Sun *sun, vector<Planet*> &planets, ld t0, ld t1, float coeff) {
+			vector<Planet> local;
+			for (auto planet : planets) local.push_back(*planet);
+			vector<Planet*> ptrs;
+			for (auto &planet : local) ptrs.push_back(&planet);
+			vector<Vector2> pos = {{comet.x, comet.y}};
+			vector<Vector2> vel = {comet.getVelocity()};
+			ld tick = H * coeff / BASE_COEFF; // столько проходит по часам планет за шаг H кометы
+			int steps = (t1 - t0) / tick;
+			for (int i = 1; i <= steps; i++) {
+				comet.updateCoords(sun, ptrs, H, [&](ld offset) {
+					for (auto planet : ptrs) planet->updateCoords(t0 + (i - 1) * tick + offset * coeff / BASE_COEFF, coeff);
+				});
+				pos.push_back({comet.x, comet.y});
+				vel.push_back(comet.getVelocity());
+			}
+			auto at = [&](ld t) {
+				ld u = (t - t0) / tick;
+				int k = min(max((int)u, 0), steps - 1);
+				float s = u - k;
+				float h00 = (1 + 2 * s) * (1 - s) * (1 - s), h10 = s * (1 - s) * (1 - s);
+				float h01 = s * s * (3 - 2 * s), h11 = s * s * (s - 1);
+				return pos[k] * h00 + vel[k] * (h10 * H) + pos[k + 1] * h01 + vel[k + 1] * (h11 * H);
+			};
+			if (steps < 2) return;
+			auto dist = [&](ld t) {
+				return (ld)Vector2Distance(at(t), {sun->x, sun->y});
+			};
+			for (ld t : find_minima(dist, t0, t0 + steps * tick, tick)) {
+				events.push_back({"перигелий", comet.getName(), "", t, dist(t)});
+			}
+			for (auto planet : planets) {
+				auto sep = [&](ld t) {
+					return (ld)Vector2Distance(at(t), planet->getPosition(t, coeff));
+				};
+				for (ld t : find_minima(sep, t0, t0 + steps * tick, tick)) {
+					events.push_back({"сближение", comet.getName(), planet->getName(), t, sep(t)});
+				}
+			}
+		}
+
+	public:
+		EventSearch() {}
+
+		vector<Event>& getEvents() {return events; }
+
+		// t - текущее время модели; события ищутся на EVENT_YEARS лет вперёд, для кометы - на COMET_EVENT_YEARS
+		// comet_t - момент, к которому относится состояние кометы (при отставании кометы он раньше t);
+		// события кометы до t уже прошли и в список не попадают
+		void search(WorkerPool *pool, Sun *sun, vector<Planet*> &planets, Comet *comet, ld comet_t, ld t) {
+			events.clear();
+			this->searchPlanets(pool, sun, planets, t, t + EVENT_YEARS * COEFF, COEFF);
+			if (comet) {
+				this->searchComet(*comet, sun, planets, comet_t, t + COMET_EVENT_YEARS * COEFF, COEFF);
+				events.erase(remove_if(events.begin(), events.end(), [&](const Event &event) {return event.time < t; }), events.end());
+			}
+			sort(events.begin(), events.end(), [](const Event &a, const Event &b) {return a.time < b.time; });
+		}
+
+		void save(const char* path, ld t) {
+			FILE *file = fopen(path, "w");
+			if (! file) return;
+			for (auto &event : events) {
+				fprintf(file, "%.4Lf\t%s\t%s\t%s\t%.2Lf\n", (event.time - t) / COEFF, event.type, event.first, event.second, event.value);
+			}
+			fclose(file);
+		}
+
+		// ближайшие события в виде текста для подсказки
+		const char* describe(ld t) {
+			int len = 0;
+			list[0] = '\0';
+			for (int i = 0; i < events.size() && i < EVENT_LIST; i++) {
+				auto &event = events[i];
+				len += snprintf(list + len, sizeof(list) - len, "%s%.2Lf г.: %s %s%s%s", (i ? "\n" : ""), (event.time - t) / COEFF,
+								event.type, event.first, (*event.second ? " - " : ""), event.second);
+				if (len >= sizeof(list)) break;
+			}
+			return list;
+		}
+};
+
+// задача N тел: Солнце, планеты и спутники притягивают друг друга. Интегрируем отображением Уиздома - Холмана
+// в демократических гелиоцентрических координатах (положения относительно Солнца, скорости относительно центра масс):
+// толчок от взаимодействий на h/2, сдвиг Солнца на h/2, кеплеровский дрейф на h, сдвиг Солнца на h/2, толчок на h/2.
+// Дрейф решается точно, поэтому шаг ограничен только возмущениями, а энергия не уходит и за миллионы лет.
+// Спутники дрейфуют по кеплеровским орбитам вокруг своей планеты и возмущаются приливными силами Солнца и планет
+// и притяжением соседних спутников; обратное притяжение спутников на планеты не учитываем.
+// Расстояния - в единицах карты, время - в годах; mu центра берём из орбиты самого тела (mu = 4 pi^2 a^3 / T^2),
+// чтобы без возмущений тела шли по тем же эллипсам, что и в режиме Кеплера
+class NBodySystem {
+	private:
+		struct Body {
+			RotatingObject *object;
+			int host; // номер планеты для спутника, -1 для планеты
+			double mu; // GM центра, вокруг которого идёт дрейф
+			double gm; // GM самого тела (для спутника - в единицах его планеты)
+			double x, y; // планета: относительно Солнца, спутник: относительно планеты
+			double vx, vy; // планета: относительно центра масс, спутник: относительно планеты
+		};
+		vector<Body> bodies; // сначала планеты, потом спутники
+		int planet_count = 0;
+		double mu_sun = 0;
+		vector<double> ax, ay;
+		double energy0 = 0;
+
+		// положение и скорость на кеплеровской орбите в момент years
+		Body orbit(RotatingObject *object, int host, double years) {
+			double a = object->getAxis(), e = object->getEccentricity();
+			double n = 2 * PI / object->getPeriod();
+			double E = kepler(fmod(n * years, 2 * PI), e);
+			double b = a * sqrt(1 - e * e);
+			double E_dot = n / (1 - e * cos(E));
+			return {object, host, n * n * a * a * a, 0, a * (cos(E) - e), b * sin(E), -a * sin(E) * E_dot, b * cos(E) * E_dot};
+		}
+
+		static void pull(double gm, double dx, double dy, double &ax, double &ay) {
+			double r2 = dx * dx + dy * dy;
+			double k = gm / (r2 * sqrt(r2));
+			ax += k * dx;
+			ay += k * dy;
+		}
+
+		void kick(double h) {
+			for (int i = 0; i < bodies.size(); i++) {
+				Body &body = bodies[i];
+				ax[i] = ay[i] = 0;
+				if (body.host < 0) {
+					for (int j = 0; j < planet_count; j++) {
+						if (j != i) pull(bodies[j].gm, bodies[j].x - body.x, bodies[j].y - body.y, ax[i], ay[i]);
+					}
+					continue;
+				}
+				// приливное ускорение: притяжение тела на спутник минус притяжение того же тела на его планету
+				Body &host = bodies[body.host];
+				double px = host.x + body.x, py = host.y + body.y;
+				pull(mu_sun, -px, -py, ax[i], ay[i]);
+				pull(-mu_sun, -host.x, -host.y, ax[i], ay[i]);
+				for (int j = 0; j < planet_count; j++) {
+					if (j == body.host) continue;
+					pull(bodies[j].gm, bodies[j].x - px, bodies[j].y - py, ax[i], ay[i]);
+					pull(-bodies[j].gm, bodies[j].x - host.x, bodies[j].y - host.y, ax[i], ay[i]);
+				}
+				for (int j = planet_count; j < bodies.size(); j++) {
+					if (j != i && bodies[j].host == body.host) pull(bodies[j].gm, bodies[j].x - body.x, bodies[j].y - body.y, ax[i], ay[i]);
+				}
+			}
+			for (int i = 0; i < bodies.size(); i++) {
+				bodies[i].vx += ax[i] * h;
+				bodies[i].vy += ay[i] * h;
+			}
+		}
+
+		// движение Солнца относительно центра масс сдвигает гелиоцентрические положения планет
+		void jump(double h) {
+			double px = 0, py = 0;
+			for (int i = 0; i < planet_count; i++) {
+				px += bodies[i].gm * bodies[i].vx;
+				py += bodies[i].gm * bodies[i].vy;
+			}
+			for (int i = 0; i < planet_count; i++) {
+				bodies[i].x += px / mu_sun * h;
+				bodies[i].y += py / mu_sun * h;
+			}
+		}
+
+		void drift(double h) {
+			for (auto &body : bodies) kepler_universal(body.mu, h, body.x, body.y, body.vx, body.vy);
+		}
+
+		void step(double h) {
+			this->kick(h / 2);
+			this->jump(h / 2);
+			this->drift(h);
+			this->jump(h / 2);
+			this->kick(h / 2);
+		}
+
+		// координаты на карте; спутники, как и в режиме Кеплера, отодвигаем на радиусы изображений
+		void place() {
+			for (auto &body : bodies) {
+				if (body.host < 0) {
+					body.object->x = CENTER.x + body.x;
+					body.object->y = CENTER.y + body.y;
+					continue;
+				}
+				RotatingObject *host = bodies[body.host].object;
+				double r = sqrt(body.x * body.x + body.y * body.y);
+				double k = 1 + (body.object->getA() - body.object->getAxis()) / r;
+				body.object->x = host->x + body.x * k;
+				body.object->y = host->y + body.y * k;
+			}
+		}
+
+	public:
+		NBodySystem() {}
+
+		// начальное состояние - положения и скорости на кеплеровских орбитах в момент t
+		void start(Sun *sun, vector<Planet*> &planets, vector<Satellite*> &satellites, ld t, float coeff) {
+			double years = t / coeff;
+			bodies.clear();
+			planet_count = planets.size();
+			// GM Солнца в единицах карты - среднее по третьему закону Кеплера для всех планет
+			mu_sun = 0;
+			for (auto planet : planets) {
+				mu_sun += 4 * PI * PI * pow((double)planet->getAxis(), 3) / pow((double)planet->getPeriod(), 2) / planets.size();
+			}
+			double total = mu_sun, px = 0, py = 0;
+			for (auto planet : planets) {
+				Body body = this->orbit(planet, -1, years);
+				body.gm = mu_sun * planet->getMass() / sun->getMass();
+				total += body.gm;
+				px += body.gm * body.vx;
+				py += body.gm * body.vy;
+				bodies.push_back(body);
+			}
+			for (int i = 0; i < planet_count; i++) {
+				bodies[i].vx -= px / total;
+				bodies[i].vy -= py / total;
+			}
+			for (auto satellite : satellites) {
+				int host = find(planets.begin(), planets.end(), satellite->getPlanet()) - planets.begin();
+				Body body = this->orbit(satellite, host, years);
+				body.gm = body.mu * satellite->getMass() / satellite->getPlanet()->getMass();
+				bodies.push_back(body);
+			}
+			ax.assign(bodies.size(), 0);
+			ay.assign(bodies.size(), 0);
+			energy0 = this->getEnergy();
+			this->place();
+		}
+
+		// сдвигаем систему на years лет шагами не больше max_step; для долгого счёта вековой эволюции
+		// без спутников шаг можно брать порядка 1/20 периода Меркурия
+		void advance(double years, double max_step = NBODY_STEP) {
+			int steps = max(1, (int)ceil(years / max_step));
+			for (int i = 0; i < steps; i++) this->step(years / steps);
+			this->place();
+		}
+
+		// полная энергия планет (её сохранение - проверка точности шага)
+		double getEnergy() {
+			double energy = 0, px = 0, py = 0;
+			for (int i = 0; i < planet_count; i++) {
+				Body &body = bodies[i];
+				energy += body.gm * ((body.vx * body.vx + body.vy * body.vy) / 2 - body.mu / sqrt(body.x * body.x + body.y * body.y));
+				for (int j = i + 1; j < planet_count; j++) {
+					energy -= body.gm * bodies[j].gm / sqrt(pow(bodies[j].x - body.x, 2) + pow(bodies[j].y - body.y, 2));
+				}
+				px += body.gm * body.vx;
+				py += body.gm * body.vy;
+			}
+			return energy + (px * px + py * py) / (2 * mu_sun);
+		}
+
+		// относительное изменение энергии с момента запуска
+		double getEnergyError() {
+			return abs(this->getEnergy() / energy0 - 1);
+		}
+};
+
+// пояс астероидов: орбиты хранятся непрерывными массивами, положения пересчитываются в пуле потоков в один буфер.
+// Рисуется без CosmicObject::render и подписей: заметные на экране астероиды - спрайтами одной текстуры,
+// маленькие - точками, а меньше пикселя - плотностью: число астероидов в каждом пикселе копится в буфере
+// и выводится одной текстурой на весь экран
+class AsteroidBelt {
+	private:
+		struct Splat { // буфер плотности под размер окна или записываемого кадра
+			int width, height;
+			vector<unsigned char> density;
+			vector<Color> pixels;
+			Texture2D texture;
+		};
+		int count;
+		vector<float> a, b, e, n, m0, cos_w, sin_w, radius; // n - среднее движение (рад / год), m0 - средняя аномалия при t = 0
+		vector<Vector2> positions;
+		vector<int> points, sprites; // видимые астероиды размером больше пикселя
+		vector<Splat> splats;
+		Color palette[256];
+		float max_speed = 0;
+		ld updated = -1;
+		float updated_coeff = 0;
+		WorkerPool *pool;
+
+		Splat& getSplat(int width, int height) {
+			for (auto &splat : splats) {
+				if (splat.width == width && splat.height == height) return splat;
+			}
+			Image image = GenImageColor(width, height, BLANK);
+			splats.push_back({width, height, vector<unsigned char>(width * height), vector<Color>(width * height), LoadTextureFromImage(image)});
+			UnloadImage(image);
+			return splats.back();
+		}
+
+	public:
+		AsteroidBelt(int count, WorkerPool *pool) {
+			this->count = count;
+			this->pool = pool;
+			uniform_real_distribution<float> uniform(0, 1);
+			for (int i = 0; i < count; i++) {
+				float axis = 150 * SCALE * (BELT_INNER + (BELT_OUTER - BELT_INNER) * uniform(rnd)); // в а. е. Земли
+				float ecc = 0.25 * uniform(rnd);
+				float w = 2 * PI * uniform(rnd);
+				a.push_back(axis);
+				b.push_back(axis * sqrt(1 - ecc * ecc));
+				e.push_back(ecc);
+				n.push_back(2 * PI / pow(axis / (150 * SCALE), 1.5f));
+				m0.push_back(2 * PI * uniform(rnd));
+				cos_w.push_back(cos(w));
+				sin_w.push_back(sin(w));
+				// диаметр 1-100 км, мелких больше; как и у спутников Марса, увеличен в 10 раз
+				radius.push_back((1 + 99 * pow(uniform(rnd), 3)) * 10 / 1e2 / 2);
+				// скорость в перигелии - самая большая на орбите
+				max_speed = max(max_speed, n[i] * axis * sqrt((1 + ecc) / (1 - ecc)));
+			}
+			positions.resize(count);
+			for (int i = 0; i < 256; i++) {
+				float alpha = min(1.0f, log2f(1 + i) / log2f(1 + BELT_SATURATION));
+				palette[i] = {200, 180, 150, (unsigned char)(alpha * 255)};
+			}
+		}
+
+		// наибольшая скорость астероида в единицах карты за год
+		float getMaxSpeed() {return max_speed; }
+
+		void update(ld t, float coeff) {
+			if (t == updated && coeff == updated_coeff) return;
+			updated = t;
+			updated_coeff = coeff;
+			double years = t / coeff;
+			pool->run((count + BELT_CHUNK - 1) / BELT_CHUNK, [&](int chunk) {
+				for (int i = chunk * BELT_CHUNK; i < min(count, (chunk + 1) * BELT_CHUNK); i++) {
+					// при e <= 0.25 от начального приближения E = M + e sin M хватает трёх шагов Ньютона до точности float;
+					// синус и косинус после последнего шага d не пересчитываем, а поправляем линейно
+					float M = fmod(m0[i] + n[i] * years, 2 * PI);
+					float E = M + e[i] * sinf(M), s, c, d;
+					for (int k = 0; k < 3; k++) {
+						sincosf(E, &s, &c);
+						d = (E - e[i] * s - M) / (1 - e[i] * c);
+						E -= d;
+					}
+					float px = a[i] * (c + s * d - e[i]), py = b[i] * (s - c * d);
+					positions[i] = {CENTER.x + px * cos_w[i] - py * sin_w[i], CENTER.y + px * sin_w[i] + py * cos_w[i]};
+				}
+			});
+		}
+
+		// рисуется внутри BeginMode2D(camera); width, height - размер области вывода в пикселях
+		void render(Camera2D camera, int width, int height) {
+			Splat &splat = this->getSplat(width, height);
+			fill(splat.density.begin(), splat.density.end(), 0);
+			points.clear();
+			sprites.clear();
+			bool splatted = 0;
+			float sprite_size = 0;
+			for (int i = 0; i < count; i++) {
+				float sx = (positions[i].x - camera.target.x) * camera.zoom + camera.offset.x;
+				float sy = (positions[i].y - camera.target.y) * camera.zoom + camera.offset.y;
+				if (sx < 0 || sy < 0 || sx >= width || sy >= height) continue;
+				float size = 2 * radius[i] * camera.zoom;
+				if (size >= BELT_SPRITE_SIZE) {
+					sprites.push_back(i);
+					sprite_size = max(sprite_size, size);
+				}
+				else if (size >= 1) points.push_back(i);
+				else {
+					unsigned char &cell = splat.density[(int)sy * width + (int)sx];
+					if (cell < 255) cell++;
+					splatted = 1;
+				}
+			}
+			if (splatted) {
+				for (int i = 0; i < splat.pixels.size(); i++) splat.pixels[i] = palette[splat.density[i]];
+				UpdateTexture(splat.texture, splat.pixels.data());
+				Vector2 corner = GetScreenToWorld2D({0, 0}, camera);
+				DrawTexturePro(splat.texture, {0, 0, (float)width, (float)height},
+							   {corner.x, corner.y, width / camera.zoom, height / camera.zoom}, {0, 0}, 0, WHITE);
+			}
+			for (int i : points) {
+				DrawRectangleV({positions[i].x - radius[i], positions[i].y - radius[i]}, {2 * radius[i], 2 * radius[i]}, palette[255]);
+			}
+			if (sprites.empty()) return;
+			// все спрайты из одной текстуры попадают в один пакет отрисовки
+			Texture2D texture = textures.get(BELT_PICTURE, sprite_size);
+			Rectangle src = {0, 0, (float)texture.width, (float)texture.height};
+			for (int i : sprites) {
+				DrawTexturePro(texture, src, {positions[i].x, positions[i].y, 2 * radius[i], 2 * radius[i]}, {radius[i], radius[i]}, 0, WHITE);
+			}
+		}
+
+		void unload() {
+			for (auto &splat : splats) UnloadTexture(splat.texture);
+			splats.clear();
+		}
+};
+
 int main() {
     InitWindow(WIDTH, HEIGHT, "Компьютерная модель Солнечной системы");
-    SetTargetFPS(60); 
-	load_images();
+    SetTargetFPS(FPS); 
+	textures.start();
 	load_font();
 	
 	int x = WIDTH - BAR + PAGINATION;
@@ -519,6 +1477,7 @@ int main() {
 	TextBox input_velocity = TextBox(x + 15 + label_velocity.getLength(), 40, 30, font_color, textbox_color);
 	Button comet_button = Button("Смоделировать перелёт кометы", x, 80, font, 30, font_color, btn_color);
 	Label label_error = Label("", x, 115, font, 30, error_color);
+	Label label_lag = Label("", PAGINATION, PAGINATION, font, 25, hide_color); // в углу сцены, когда комета не успевает
 	Button inc_speed = Button("Ускорить движение", x, 160, font, 30, font_color, inc_color);
 	Button dec_speed = Button("Замедлить движение", x + 195, 160, font, 30, font_color, dec_color);
 	LabelWithBG label_info = LabelWithBG("Показать справку",
@@ -526,9 +1485,15 @@ int main() {
 							 			 "Чтобы переместить, зажмите правую кнопку мыши.\n"
 							 			 "Чтобы скрыть название планеты, нажмите на неё.\n"
 			 				 			 "Чтобы вернуться к исходному состоянию\n"
-							 			 "камеры, нажмите на клавиатуре клавишу R.", 5, 
+							 			 "камеры, нажмите на клавиатуре клавишу R.\n"
+										 "Чтобы показать пояс астероидов, нажмите A.", 6, 
 										 x + 55, 450, font, 50, 25, error_color, hide_color);
-
+	CheckBox record_frames = CheckBox({"Записать кадры", "Остановить запись"}, x, 510, font, 25, BLACK, {show_color, hide_color});
+	Button events_button = Button("Найти события", x, 545, font, 25, font_color, btn_color);
+	LabelWithText label_events = LabelWithText("События", "Поиск ещё не выполнен", 1, x + 200, 545, font, 25, 25, font_color);
+	CheckBox potential_button = CheckBox({"Поле потенциала", "Скрыть поле"}, x, 575, font, 25, BLACK, {show_color, hide_color});
+	CheckBox sweep_button = CheckBox({"Серия запусков", "Скрыть карту"}, x + 200, 510, font, 25, BLACK, {show_color, hide_color});
+	CheckBox nbody_button = CheckBox({"Задача N тел", "Орбиты Кеплера"}, x + 200, 575, font, 25, BLACK, {show_color, hide_color});
 
 	Comet comet = Comet();
 	bool show_comet = 0;
@@ -577,7 +1542,6 @@ int main() {
 	vector<Color> colors = {show_color, hide_color};
 	float y = 200;
 	for (int i = 0; i < n; i++) {
-		auto info = objects[i]->getInfo();
 		labels[i] = LabelWithText(objects[i]->getName(), objects[i]->getInfo(), 2, x + 20, y, font, 25, 25, font_color);
 		checkboxes[i] = CheckBox(texts, x + 110, y, font, 25, BLACK, colors);
 		y += 30; // располагаем в 2 столбца
@@ -594,22 +1558,173 @@ int main() {
 		camera.target = CENTER;
 	};
 	restart_camera();
+	WorkerPool workers = WorkerPool();
+	AsteroidBelt belt = AsteroidBelt(BELT_COUNT, &workers);
+	bool show_belt = 0;
+	float belt_shift = 0; // на сколько пикселей могли сдвинуться астероиды с последнего кадра
+	auto draw_scene = [&](Camera2D view, int width, int height) {
+		for (auto planet : planets) (*planet).drawOrbit();
+		for (auto satellite : satellites) (*satellite).drawOrbit();
+		if (show_belt) {
+			belt.update(t, COEFF);
+			belt.render(view, width, height);
+		}
+		for (auto obj : objects) (*obj).render();
+		if (show_comet) comet.render();
+	};
+
+	// кадры для записи рисуются в текстуру отдельно от окна и отдаются кодировщикам
+	FrameExporter exporter = FrameExporter(EXPORT_FORMAT, thread::hardware_concurrency() - 1, EXPORT_QUEUE);
+	RenderTexture2D export_target = LoadRenderTexture(EXPORT_WIDTH, EXPORT_HEIGHT);
+	auto export_frame = [&]() {
+		float scale = (float)EXPORT_HEIGHT / HEIGHT;
+		Camera2D export_camera = camera;
+		export_camera.zoom *= scale;
+		export_camera.offset *= scale;
+		export_camera.offset.x += (EXPORT_WIDTH - (WIDTH - BAR) * scale) / 2;
+		BeginTextureMode(export_target);
+		ClearBackground(BLACK);
+		VIEW_ZOOM = export_camera.zoom;
+		BeginMode2D(export_camera);
+		draw_scene(export_camera, EXPORT_WIDTH, EXPORT_HEIGHT);
+		EndMode2D();
+		EndTextureMode();
+		Image frame = LoadImageFromTexture(export_target.texture);
+		ImageFlipVertical(&frame);
+		exporter.push(frame);
+	};
+	// статичная картинка не перерисовывается: кадр рисуется только при вводе или заметном движении
+	FrameScheduler scheduler = FrameScheduler(MIN_MOTION, FPS);
+	vector<Vector2> positions(n + 1); // тела и комета
+
+	// серия запусков считается в фоне, по готовности показывается тепловая карта исходов
+	CometSweep sweep = CometSweep();
+	bool show_sweep = 0;
+	int sweep_progress = -1;
+	auto toggle_sweep = [&]() {
+		show_sweep ^= 1;
+		if (show_sweep) {
+			sweep.start(&sun, planets, t);
+			sweep_progress = -1;
+		}
+		else if (sweep.isRunning()) {
+			sweep.cancel();
+			label_error.setText("Серия запусков отменена.");
+		}
+	};
+	auto update_sweep = [&]() {
+		if (! show_sweep) return;
+		if (sweep.isRunning() && sweep.getProgress() != sweep_progress) {
+			sweep_progress = sweep.getProgress();
+			label_error.format("Серия запусков: %d%%", sweep_progress);
+			scheduler.invalidate();
+		}
+		else if (sweep.isReady() && sweep_progress != 100) {
+			sweep_progress = 100;
+			label_error.setText("Серия готова: sweep.csv");
+			scheduler.invalidate();
+		}
+	};
+
+	// поле потенциала Солнца и планет (тех же тел, что притягивают комету)
+	PotentialOverlay potential = PotentialOverlay(WIDTH - BAR, HEIGHT, POTENTIAL_CELL, POTENTIAL_RADIUS, &workers);
+	bool show_potential = 0;
+	vector<Vector2> attractors(planets.size() + 1);
+	vector<float> attractor_mu = {(float)(G * sun.getMass() * 1e-14)};
+	for (auto planet : planets) attractor_mu.push_back(G * planet->getMass() * 1e-14);
+	auto update_potential = [&]() {
+		attractors[0] = {sun.x, sun.y};
+		for (int i = 0; i < planets.size(); i++) attractors[i + 1] = {planets[i]->x, planets[i]->y};
+		potential.update(attractors, attractor_mu, camera);
+	};
+
+	ld comet_years = 0; // момент (в годах), до которого досчитана комета
+
+	EventSearch event_search = EventSearch();
+	auto search_events = [&]() {
+		double start = GetTime();
+		event_search.search(&workers, &sun, planets, show_comet ? &comet : nullptr, comet_years * COEFF, t);
+		double elapsed = (GetTime() - start) * 1000;
+		event_search.save("events.txt", t);
+		label_events.formatSubText(max(1, min((int)event_search.getEvents().size(), EVENT_LIST)), "%s", event_search.describe(t));
+		label_error.format("Событий: %d (%.0f мс)", (int)event_search.getEvents().size(), elapsed);
+	};
+
+	// в режиме N тел планеты и спутники движутся под действием взаимного притяжения, а не по формулам Кеплера
+	NBodySystem nbody = NBodySystem();
+	bool nbody_mode = 0;
+	auto toggle_nbody = [&]() {
+		nbody_mode ^= 1;
+		if (nbody_mode) {
+			nbody.start(&sun, planets, satellites, t, COEFF);
+			label_error.setText("Режим N тел.");
+		}
+		else label_error.format("Ошибка энергии: %.1e", nbody.getEnergyError());
+	};
+
+	// комета идёт по тем же часам, что и планеты: за кадр проходит 0.05 / COEFF лет, то есть H * BASE_COEFF / COEFF
+	// её времени (куски движения - см. Comet::advance; в режиме N тел планеты известны только на текущий момент).
+	// Одна траектория считается последовательно, поэтому при сильном ускорении на неё тратится не больше
+	// COMET_BUDGET секунд за кадр, а недосчитанное время переносится на следующие кадры
+	auto update_comet = [&]() {
+		ld now = t / COEFF;
+		double deadline = GetTime() + COMET_BUDGET;
+		while (now - comet_years > EPS && GetTime() < deadline) {
+			comet_years += comet.advance(&sun, planets, (now - comet_years) * BASE_COEFF, [&](ld offset) {
+				if (nbody_mode) return;
+				for (auto planet : planets) planet->updateCoords((comet_years + offset / BASE_COEFF) * COEFF);
+			}, 1) / BASE_COEFF;
+		}
+		if (! nbody_mode) {
+			for (auto planet : planets) planet->updateCoords(t);
+		}
+		ld lag = now - comet_years;
+		if (lag > EPS) {
+			label_lag.format("Комета отстаёт на %.2Lf г.", lag);
+			scheduler.invalidate();
+		}
+		else label_lag.setText("");
+	};
+
+	auto toggle_recording = [&]() {
+		if (exporter.isRunning()) {
+			exporter.stop();
+			SetTargetFPS(FPS);
+			label_error.format("Записано кадров: %d", exporter.getCount());
+		}
+		else if (! exporter.start()) {
+			record_frames.reset();
+			label_error.format("Не удалось создать %s", exporter.getDir());
+		}
+		else {
+			SetTargetFPS(0); // при записи скорость ограничена кодировщиками, а не частотой кадров
+			label_error.format("Запись в %s", exporter.getDir());
+		}
+	};
+
     while (!WindowShouldClose()) {
-		BeginDrawing();
-        ClearBackground(BLACK);
 		if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
 			input_mass.setCursor();
 			input_velocity.setCursor();
-			if (comet_button.click()) model_comet();
+			if (comet_button.click()) {
+				model_comet();
+				comet_years = t / COEFF;
+			}
 			for (int i = 0; i < n; i++) {
 				if (checkboxes[i].toggle()) show_object[i] ^= 1;
 			}
+			if (record_frames.toggle()) toggle_recording();
+			if (sweep_button.toggle()) toggle_sweep();
+			if (events_button.click()) search_events();
+			if (potential_button.toggle()) show_potential ^= 1;
+			if (nbody_button.toggle()) toggle_nbody();
 			Vector2 real_pos = GetScreenToWorld2D(GetMousePosition(), camera);
 			for (auto obj : objects) { 
 				obj->showText(real_pos);
 			}
-			if (inc_speed.click() && COEFF >= MIN_COEFF * 2) COEFF /= 2;
-			else if (dec_speed.click()) COEFF *= 2;
+			// часы пересчитываем вместе со скоростью, чтобы время в годах t / COEFF не прыгало
+			if (inc_speed.click() && COEFF >= MIN_COEFF * 2) COEFF /= 2, t /= 2;
+			else if (dec_speed.click()) COEFF *= 2, t *= 2;
 		}
 		if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT)) {
 			Vector2 delta = GetMouseDelta();
@@ -633,40 +1748,71 @@ int main() {
 		if (IsKeyPressed(KEY_R)) {
 			restart_camera();
 		}
-		BeginMode2D(camera);
-		for (auto planet : planets) {
-			(*planet).updateCoords(t);
-			(*planet).drawOrbit();
+		if (IsKeyPressed(KEY_A)) {
+			show_belt ^= 1;
+			scheduler.invalidate();
 		}
-		for (auto satellite : satellites) {
-			(*satellite).updateCoords(t);
-			(*satellite).drawOrbit();
+		if (nbody_mode) nbody.advance(0.05 / COEFF, max(NBODY_STEP, 0.05 / COEFF / NBODY_MAX_STEPS));
+		else {
+			for (auto planet : planets) (*planet).updateCoords(t);
+			for (auto satellite : satellites) (*satellite).updateCoords(t);
 		}
-		for (auto obj : objects) (*obj).render();
-		if (show_comet) {
-			comet.updateCoords(&sun, planets);
-			comet.render();
+		if (show_comet) update_comet();
+		if (exporter.isRunning()) export_frame();
+		update_sweep();
+		if (show_potential) update_potential();
+		if (textures.update()) scheduler.invalidate();
+		if (show_belt) {
+			belt_shift += belt.getMaxSpeed() * 0.05 / COEFF * camera.zoom;
+			if (belt_shift >= MIN_MOTION) scheduler.invalidate();
 		}
-		EndMode2D();
-		DrawRectangle(WIDTH - BAR, 0, BAR, HEIGHT, WHITE);
-		label_mass.render();
-		input_mass.render();
-		comet_button.render();
-		inc_speed.render();
-		dec_speed.render();
-		label_velocity.render();
-		input_velocity.render();
-		label_error.render();
-		label_info.render();
-		bool show_text = 0;
-		for (int i = 0; i < n; i++) labels[i].render();
-		for (auto chkbx : checkboxes) (&chkbx)->render();
-		for (int i = 0; i < n; i++) {
-			if (labels[i].showText()) break;
-		}
-		label_info.showText();
-		EndDrawing();
+
+		for (int i = 0; i < n; i++) positions[i] = {objects[i]->x, objects[i]->y};
+		positions[n] = {comet.x, comet.y};
+		bool busy = exporter.isRunning() || sweep.isRunning() || input_mass.isActive() || input_velocity.isActive();
+		if (scheduler.needsRedraw(positions, camera, busy)) {
+			BeginDrawing();
+			ClearBackground(BLACK);
+			if (show_potential) potential.render();
+			textures.beginFrame();
+			VIEW_ZOOM = camera.zoom;
+			BeginMode2D(camera);
+			draw_scene(camera, WIDTH - BAR, HEIGHT);
+			EndMode2D();
+			belt_shift = 0;
+			if (show_sweep && sweep.isReady()) sweep.render(font, {60, 60, WIDTH - BAR - 120, HEIGHT - 120});
+			if (show_comet) label_lag.render();
+			DrawRectangle(WIDTH - BAR, 0, BAR, HEIGHT, WHITE);
+			label_mass.render();
+			input_mass.render();
+			comet_button.render();
+			inc_speed.render();
+			dec_speed.render();
+			label_velocity.render();
+			input_velocity.render();
+			label_error.render();
+			label_info.render();
+			record_frames.render();
+			sweep_button.render();
+			events_button.render();
+			label_events.render();
+			potential_button.render();
+			nbody_button.render();
+			for (int i = 0; i < n; i++) labels[i].render();
+			for (auto &chkbx : checkboxes) chkbx.render();
+			for (int i = 0; i < n; i++) {
+				if (labels[i].showText()) break;
+			}
+			label_info.showText();
+			label_events.showText();
+			EndDrawing();
+		}
+		else scheduler.skipFrame();
 		t += 0.05;
 	}
+	exporter.stop();
+	UnloadRenderTexture(export_target);
+	belt.unload();
+	textures.unload();
     CloseWindow(); 
 }
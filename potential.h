@@ -0,0 +1,143 @@
+#include "header.h"
+
+// поле гравитационного потенциала phi = -sum(GM / r) на экранной сетке ячеек cell x cell пикселей;
+// сетка разбита на плитки, плитки считаются в пуле потоков и пересчитываются только при смене камеры
+// или рядом с телами, сдвинувшимися на экране хотя бы на пиксель
+class PotentialOverlay {
+	private:
+		int width, height;
+		int cell;
+		int cols, rows;
+		static const int TILE = 32; // сторона плитки в ячейках
+		int tile_cols, tile_rows;
+		float radius; // в каком радиусе (в пикселях) от сдвинувшегося тела пересчитываются плитки
+		WorkerPool *pool;
+		vector<Color> pixels;
+		vector<char> dirty;
+		vector<int> queue; // номера плиток для пересчёта
+		vector<float> bx, by, gm; // тела в мировых координатах (структура массивов для векторизации)
+		vector<Vector2> drawn; // экранные положения тел при последнем пересчёте
+		Camera2D camera = {0};
+		Texture2D texture = {0};
+		bool changed = 0;
+
+		static Color ramp(float value) {
+			// тёмно-синий -> фиолетовый -> оранжевый -> жёлтый
+			const Color stops[] = {{20, 30, 120, 0}, {110, 40, 160, 110}, {230, 120, 40, 150}, {250, 240, 120, 180}};
+			value = Clamp(value, 0, 1) * 3;
+			int i = min((int)value, 2);
+			float k = value - i;
+			Color a = stops[i], b = stops[i + 1];
+			return {(unsigned char)Lerp(a.r, b.r, k), (unsigned char)Lerp(a.g, b.g, k),
+					(unsigned char)Lerp(a.b, b.b, k), (unsigned char)Lerp(a.a, b.a, k)};
+		}
+
+		void markAround(Vector2 pos) {
+			int c0 = max(0, (int)((pos.x - radius) / (cell * TILE))), c1 = min(tile_cols - 1, (int)((pos.x + radius) / (cell * TILE)));
+			int r0 = max(0, (int)((pos.y - radius) / (cell * TILE))), r1 = min(tile_rows - 1, (int)((pos.y + radius) / (cell * TILE)));
+			for (int r = r0; r <= r1; r++) {
+				for (int c = c0; c <= c1; c++) dirty[r * tile_cols + c] = 1;
+			}
+		}
+
+		// внутренний цикл идёт по непрерывному ряду из TILE ячеек без ветвлений, поэтому компилятор векторизует его;
+		// у правого края лишние ячейки считаются, но не записываются
+		void computeTile(int index) {
+			float wx[TILE], phi[TILE];
+			int tc = index % tile_cols, tr = index / tile_cols;
+			int c0 = tc * TILE, c1 = min(cols, c0 + TILE);
+			int n = c1 - c0;
+			for (int r = tr * TILE; r < min(rows, (tr + 1) * TILE); r++) {
+				float wy = (r * cell + cell / 2.0f - camera.offset.y) / camera.zoom + camera.target.y;
+				for (int i = 0; i < TILE; i++) {
+					wx[i] = ((c0 + i) * cell + cell / 2.0f - camera.offset.x) / camera.zoom + camera.target.x;
+					phi[i] = 0;
+				}
+				for (int k = 0; k < gm.size(); k++) {
+					float x = bx[k], dy = wy - by[k], m = gm[k];
+					for (int i = 0; i < TILE; i++) {
+						float dx = wx[i] - x;
+						phi[i] += m / sqrtf(dx * dx + dy * dy + 1e-6f);
+					}
+				}
+				for (int i = 0; i < n; i++) {
+					pixels[r * cols + c0 + i] = ramp((log10f(phi[i]) - log_min) / (log_max - log_min));
+				}
+			}
+		}
+
+	public:
+		float log_min = 1.5; // диапазон log10(-phi), который растягивается на всю шкалу цветов
+		float log_max = 5.5;
+
+		PotentialOverlay(int width, int height, int cell, float radius, WorkerPool *pool) {
+			this->width = width;
+			this->height = height;
+			this->cell = cell;
+			this->radius = radius;
+			this->pool = pool;
+			cols = (width + cell - 1) / cell;
+			rows = (height + cell - 1) / cell;
+			tile_cols = (cols + TILE - 1) / TILE;
+			tile_rows = (rows + TILE - 1) / TILE;
+			pixels.assign(cols * rows, BLANK);
+			dirty.assign(tile_cols * tile_rows, 1);
+			queue.reserve(dirty.size());
+		}
+
+		// positions и mu (GM в единицах карты) - тела, притягивающие комету (те же, что в Comet::getA)
+		void update(vector<Vector2> &positions, vector<float> &mu, Camera2D camera) {
+			bool moved_camera = memcmp(&camera, &this->camera, sizeof(Camera2D)) != 0 || drawn.size() != positions.size();
+			if (moved_camera) {
+				fill(dirty.begin(), dirty.end(), 1);
+				drawn.resize(positions.size());
+				this->camera = camera;
+			}
+			else {
+				for (int i = 0; i < positions.size(); i++) {
+					Vector2 pos = GetWorldToScreen2D(positions[i], camera);
+					if (Vector2Distance(pos, drawn[i]) >= 1) {
+						this->markAround(drawn[i]);
+						this->markAround(pos);
+					}
+				}
+			}
+			queue.clear();
+			for (int i = 0; i < dirty.size(); i++) {
+				if (dirty[i]) queue.push_back(i);
+			}
+			if (queue.empty()) return;
+			bx.resize(positions.size());
+			by.resize(positions.size());
+			gm.resize(positions.size());
+			for (int i = 0; i < positions.size(); i++) {
+				bx[i] = positions[i].x;
+				by[i] = positions[i].y;
+				gm[i] = mu[i];
+				drawn[i] = GetWorldToScreen2D(positions[i], camera);
+			}
+			pool->run(queue.size(), [&](int i) {
+				this->computeTile(queue[i]);
+			});
+			fill(dirty.begin(), dirty.end(), 0);
+			changed = 1;
+		}
+
+		void render() {
+			if (! texture.id) {
+				Image image = GenImageColor(cols, rows, BLANK);
+				texture = LoadTextureFromImage(image);
+				UnloadImage(image);
+				SetTextureFilter(texture, TEXTURE_FILTER_BILINEAR);
+			}
+			if (changed) {
+				UpdateTexture(texture, pixels.data());
+				changed = 0;
+			}
+			DrawTexturePro(texture, {0, 0, (float)cols, (float)rows}, {0, 0, (float)cols * cell, (float)rows * cell}, {0, 0}, 0, WHITE);
+		}
+
+		~PotentialOverlay() {
+			if (texture.id) UnloadTexture(texture);
+		}
+};
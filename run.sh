@@ -1,3 +1,3 @@
 #!/bin/bash
-g++ main.cpp -lraylib
+g++ -O2 -fno-math-errno main.cpp -lraylib -pthread
 ./a.out
@@ -0,0 +1,58 @@
+#include "header.h"
+
+// планировщик кадров: окно перерисовывается, только если что-то видимое изменилось - был ввод,
+// идёт запись, либо какое-то тело (в том числе комета) сдвинулось на экране хотя бы на min_motion пикселей
+// с последнего нарисованного кадра; в остальное время цикл только опрашивает ввод и спит до следующего кадра
+class FrameScheduler {
+	private:
+		vector<Vector2> drawn; // экранные положения тел на последнем нарисованном кадре
+		Camera2D camera = {0};
+		float min_motion;
+		double frame_time;
+		bool dirty = 1; // изменилось что-то, о чём планировщик не знает (например, текст надписи)
+
+		static bool hasInput() {
+			Vector2 delta = GetMouseDelta();
+			if (delta.x != 0 || delta.y != 0 || GetMouseWheelMove() != 0) return 1;
+			for (int button = MOUSE_BUTTON_LEFT; button <= MOUSE_BUTTON_MIDDLE; button++) {
+				if (IsMouseButtonDown(button) || IsMouseButtonReleased(button)) return 1;
+			}
+			return GetKeyPressed() != 0;
+		}
+
+		static bool sameCamera(Camera2D a, Camera2D b) {
+			return a.zoom == b.zoom && a.rotation == b.rotation && a.offset.x == b.offset.x && a.offset.y == b.offset.y &&
+				   a.target.x == b.target.x && a.target.y == b.target.y;
+		}
+
+	public:
+		FrameScheduler(float min_motion, int fps) {
+			this->min_motion = min_motion;
+			this->frame_time = 1.0 / fps;
+		}
+
+		void invalidate() {
+			dirty = 1;
+		}
+
+		// positions - мировые координаты тел; busy - что-то меняется независимо от ввода и движения тел
+		bool needsRedraw(vector<Vector2> &positions, Camera2D camera, bool busy) {
+			bool redraw = busy || dirty || hasInput() || drawn.size() != positions.size() || ! sameCamera(camera, this->camera);
+			for (int i = 0; i < positions.size() && ! redraw; i++) {
+				Vector2 pos = GetWorldToScreen2D(positions[i], camera);
+				redraw = abs(pos.x - drawn[i].x) >= min_motion || abs(pos.y - drawn[i].y) >= min_motion;
+			}
+			if (! redraw) return 0;
+			drawn.resize(positions.size());
+			for (int i = 0; i < positions.size(); i++) drawn[i] = GetWorldToScreen2D(positions[i], camera);
+			this->camera = camera;
+			dirty = 0;
+			return 1;
+		}
+
+		// кадр пропущен: обрабатываем события, как это сделал бы EndDrawing, и ждём до следующего кадра
+		void skipFrame() {
+			PollInputEvents();
+			WaitTime(frame_time);
+		}
+};
@@ -0,0 +1,168 @@
+#include "header.h"
+
+// текстуры с уровнями детализации: уровень k - исходное изображение, уменьшенное в 2^k раз;
+// нужный уровень подбирается по размеру спрайта на экране и загружается в фоновом потоке,
+// а крупные уровни, которые давно не рисовались, выгружаются, когда превышен бюджет видеопамяти
+class TextureCache {
+	private:
+		struct Level {
+			Texture2D texture = {0};
+			bool loading = 0;
+			long long last_used = 0;
+		};
+
+		struct Loaded {
+			int id;
+			int level;
+			int source_size;
+			Image image;
+		};
+
+		vector<const char*> paths;
+		int levels;
+		size_t budget;
+		size_t used = 0; // байт видеопамяти под загруженные уровни
+		long long frame = 1; // номер нарисованного кадра
+		vector<vector<Level>> cache;
+		vector<int> source_size; // сторона исходного изображения, 0 - ещё не известна
+
+		thread loader;
+		mutex lock;
+		condition_variable has_request;
+		deque<pair<int, int>> requests;
+		vector<Loaded> loaded;
+		vector<Loaded> uploading;
+		bool stopping = 0;
+
+		static size_t bytes(Texture2D texture) {
+			return (size_t)texture.width * texture.height * 4;
+		}
+
+		void request(int id, int level) {
+			cache[id][level].loading = 1;
+			{
+				lock_guard<mutex> guard(lock);
+				requests.push_back({id, level});
+			}
+			has_request.notify_one();
+		}
+
+		// декодирование и уменьшение изображения не трогают OpenGL, поэтому идут в фоне;
+		// в видеопамять уровень загружает главный поток в update
+		void load() {
+			char path[256];
+			while (1) {
+				unique_lock<mutex> guard(lock);
+				has_request.wait(guard, [&]() {return ! requests.empty() || stopping; });
+				if (stopping) return;
+				auto [id, level] = requests.front();
+				requests.pop_front();
+				guard.unlock();
+				snprintf(path, sizeof(path), "assets/%s", paths[id]);
+				Image image = LoadImage(path);
+				int source = image.width;
+				int size = max(1, source >> level);
+				if (size != image.width || size != image.height) ImageResize(&image, size, size);
+				guard.lock();
+				loaded.push_back({id, level, source, image});
+			}
+		}
+
+		int levelFor(int id, float screen_size) {
+			if (! source_size[id]) return levels - 1;
+			int level = 0;
+			while (level < levels - 1 && (source_size[id] >> (level + 1)) >= screen_size) level++;
+			return level;
+		}
+
+	public:
+		TextureCache(vector<const char*> &paths, int levels, size_t budget) {
+			this->paths = paths;
+			this->levels = levels;
+			this->budget = budget;
+			cache.assign(paths.size(), vector<Level>(levels));
+			source_size.assign(paths.size(), 0);
+		}
+
+		// запускается после InitWindow: сразу запрашиваем самые мелкие уровни всех текстур
+		void start() {
+			loader = thread(&TextureCache::load, this);
+			for (int id = 0; id < paths.size(); id++) this->request(id, levels - 1);
+		}
+
+		// текстура для спрайта размером screen_size пикселей; пока нужный уровень грузится,
+		// отдаём ближайший из уже загруженных (или пустую текстуру, которую raylib не рисует)
+		Texture2D get(int id, float screen_size) {
+			auto &level = cache[id];
+			int want = this->levelFor(id, screen_size);
+			if (! level[want].texture.id && ! level[want].loading) this->request(id, want);
+			for (int d = 0; d < levels; d++) {
+				for (int k : {want + d, want - d}) {
+					if (k < 0 || k >= levels || ! level[k].texture.id) continue;
+					level[k].last_used = frame;
+					return level[k].texture;
+				}
+			}
+			return {0};
+		}
+
+		// вызывается перед рисованием кадра; уровни, взятые через get с прошлого вызова, в update не выгружаются,
+		// поэтому пропущенные планировщиком кадры не делают видимые уровни «давно не использованными»
+		void beginFrame() {
+			frame++;
+		}
+
+		// вызывается на каждой итерации цикла из главного потока; возвращает 1, если появились новые уровни
+		bool update() {
+			{
+				lock_guard<mutex> guard(lock);
+				swap(loaded, uploading);
+			}
+			for (auto &item : uploading) {
+				Level &level = cache[item.id][item.level];
+				level.texture = LoadTextureFromImage(item.image);
+				SetTextureFilter(level.texture, TEXTURE_FILTER_BILINEAR);
+				UnloadImage(item.image);
+				level.loading = 0;
+				level.last_used = frame;
+				used += bytes(level.texture);
+				source_size[item.id] = item.source_size;
+			}
+			bool changed = ! uploading.empty();
+			uploading.clear();
+			// самые мелкие уровни остаются всегда, остальные выгружаем начиная с давно не использованных
+			while (used > budget) {
+				Level *oldest = nullptr;
+				for (auto &texture : cache) {
+					for (int k = 0; k < levels - 1; k++) {
+						Level &level = texture[k];
+						if (level.texture.id && level.last_used < frame && (! oldest || level.last_used < oldest->last_used)) oldest = &level;
+					}
+				}
+				if (! oldest) break;
+				used -= bytes(oldest->texture);
+				UnloadTexture(oldest->texture);
+				oldest->texture = {0};
+			}
+			return changed;
+		}
+
+		// до CloseWindow: останавливаем загрузчик и освобождаем видеопамять
+		void unload() {
+			{
+				lock_guard<mutex> guard(lock);
+				stopping = 1;
+			}
+			has_request.notify_all();
+			if (loader.joinable()) loader.join();
+			for (auto &item : loaded) UnloadImage(item.image);
+			loaded.clear();
+			for (auto &texture : cache) {
+				for (auto &level : texture) {
+					if (level.texture.id) UnloadTexture(level.texture);
+					level.texture = {0};
+				}
+			}
+			used = 0;
+		}
+};
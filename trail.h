@@ -0,0 +1,54 @@
+#include "header.h"
+
+// след тела: кольцевой буфер последних точек фиксированной ёмкости. Последняя точка - подвижный кончик следа;
+// он закрепляется и начинается новый, только когда кончик отошёл от предыдущей точки хотя бы на min_step,
+// поэтому медленные участки не съедают буфер. Точка 0 дублируется в конце буфера, поэтому след рисуется двумя
+// непрерывными ломаными без отдельного отрезка на стыке
+class Trail {
+	private:
+		int capacity;
+		float min_step;
+		vector<Vector2> points; // capacity + 1 точек, выделяется при первой записи
+		int head = 0; // куда пишется следующая точка
+		int count = 0;
+
+		void write(int index, Vector2 pos) {
+			points[index] = pos;
+			if (index == 0) points[capacity] = pos;
+		}
+
+		int prev(int index) {return (index + capacity - 1) % capacity; }
+
+	public:
+		Trail(int capacity, float min_step) {
+			this->capacity = capacity;
+			this->min_step = min_step;
+		}
+
+		void clear() {
+			head = count = 0;
+		}
+
+		void push(Vector2 pos) {
+			if (points.empty()) points.resize(capacity + 1);
+			// кончик следа ещё близко к предыдущей точке - просто двигаем его
+			if (count >= 2 && Vector2Distance(points[prev(prev(head))], points[prev(head)]) < min_step) {
+				this->write(prev(head), pos);
+				return;
+			}
+			this->write(head, pos);
+			head = (head + 1) % capacity;
+			count = min(count + 1, capacity);
+		}
+
+		void render(Color color) {
+			if (count < 2) return;
+			int start = (head - count + capacity) % capacity; // самая старая точка
+			if (start + count <= capacity) {
+				DrawLineStrip(&points[start], count, color);
+				return;
+			}
+			DrawLineStrip(&points[start], capacity - start + 1, color); // до копии точки 0 включительно
+			if (head > 1) DrawLineStrip(&points[0], head, color);
+		}
+};
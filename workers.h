@@ -0,0 +1,105 @@
+#include "header.h"
+
+// пул потоков с перехватом работы: у каждого потока своя очередь задач, свои задачи он берёт с конца,
+// а когда его очередь пуста - забирает задачи из начала чужих очередей
+class WorkerPool {
+	private:
+		struct Task {
+			const function<void(int)> *job;
+			int index;
+			atomic<int> *remaining; // сколько задач пакета ещё не выполнено
+		};
+
+		struct Queue {
+			deque<Task> tasks;
+			mutex lock;
+		};
+
+		vector<unique_ptr<Queue>> queues;
+		vector<thread> workers;
+		atomic<int> available = 0; // задач в очередях
+		mutex lock;
+		condition_variable wake;
+		condition_variable finished;
+		bool stopping = 0;
+
+		bool take(int id, Task &task) {
+			int n = queues.size();
+			for (int k = 0; k < n; k++) {
+				Queue &queue = *queues[(id + k) % n];
+				lock_guard<mutex> guard(queue.lock);
+				if (queue.tasks.empty()) continue;
+				if (k == 0) {
+					task = queue.tasks.back();
+					queue.tasks.pop_back();
+				}
+				else {
+					task = queue.tasks.front();
+					queue.tasks.pop_front();
+				}
+				available--;
+				return 1;
+			}
+			return 0;
+		}
+
+		void execute(Task &task) {
+			(*task.job)(task.index);
+			if (--(*task.remaining) == 0) {
+				lock_guard<mutex> guard(lock);
+				finished.notify_all();
+			}
+		}
+
+		void work(int id) {
+			Task task;
+			while (1) {
+				if (this->take(id, task)) {
+					this->execute(task);
+					continue;
+				}
+				unique_lock<mutex> guard(lock);
+				wake.wait(guard, [&]() {return available > 0 || stopping; });
+				if (stopping) return;
+			}
+		}
+
+	public:
+		WorkerPool(int threads = thread::hardware_concurrency()) {
+			threads = max(1, threads);
+			for (int i = 0; i < threads; i++) queues.push_back(make_unique<Queue>());
+			for (int i = 0; i < threads; i++) workers.emplace_back(&WorkerPool::work, this, i);
+		}
+
+		int size() {return workers.size(); }
+
+		// выполняет job(0), ..., job(count - 1) и ждёт их завершения; вызывающий поток тоже берёт задачи
+		void run(int count, const function<void(int)> &job) {
+			if (count <= 0) return;
+			atomic<int> remaining = count;
+			int n = queues.size();
+			for (int i = 0; i < count; i++) {
+				Queue &queue = *queues[i % n];
+				lock_guard<mutex> guard(queue.lock);
+				queue.tasks.push_back({&job, i, &remaining});
+				available++;
+			}
+			{
+				lock_guard<mutex> guard(lock);
+			}
+			wake.notify_all();
+			Task task;
+			while (remaining > 0 && this->take(0, task)) this->execute(task);
+			unique_lock<mutex> guard(lock);
+			finished.wait(guard, [&]() {return remaining == 0; });
+		}
+
+		~WorkerPool() {
+			{
+				lock_guard<mutex> guard(lock);
+				stopping = 1;
+			}
+			wake.notify_all();
+			for (auto &worker : workers) worker.join();
+		}
+};